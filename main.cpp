@@ -1,16 +1,29 @@
 #include <iostream>
 #include <vector>
 #include <array>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <cstdio>
+#include <filesystem>
 
 #define ANKERL_NANOBENCH_IMPLEMENT
 #include "nanobench.h"
 
 #define VECEX_OVERRIDE
 #include "vectorclass_ext.h"
+#include "vectorclass_ext_dispatch.h"
+#include "vectorclass_ext_mapped.h"
+#include "vectorclass_ext_stream.h"
 
 #define TYPE float
 #define SIZE 100000
 #define MINIT 1000
+#define PARALLEL_SIZE 10000000
+#define PARALLEL_MINIT 10
+// 3 x 128 MiB, bigger than the last level cache
+#define STREAM_SIZE ( 1 << 25 )
 
 void
 bench1() {
@@ -53,7 +66,13 @@ bench1() {
     ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
             "Vector Override",
             [&]() {
-                auto c = a + b;
+                std::vector<TYPE> c = a + b;
+                ankerl::nanobench::doNotOptimizeAway( c );
+            } );
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Vector Override default_init",
+            [&]() {
+                vecex::default_init_vector<TYPE> c = a + b;
                 ankerl::nanobench::doNotOptimizeAway( c );
             } );
     ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
@@ -63,6 +82,24 @@ bench1() {
                 ankerl::nanobench::doNotOptimizeAway( result );
             } );
 
+    // a and b as foreign buffers: copied into vectors first vs used in place
+    const TYPE* buffer_a = a.data();
+    const TYPE* buffer_b = b.data();
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Vector IN copied buffer",
+            [&]() {
+                std::vector<TYPE> copy_a( buffer_a, buffer_a + SIZE );
+                std::vector<TYPE> copy_b( buffer_b, buffer_b + SIZE );
+                vecex::add_in( copy_a, copy_b, result );
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Pointer IN",
+            [&]() {
+                vecex::add_in( buffer_a, buffer_b, result.data(), SIZE );
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+
     ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
             "Compute",
             [&]() {
@@ -77,6 +114,195 @@ bench1() {
                         } );
                 ankerl::nanobench::doNotOptimizeAway( result );
             } );
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Compute load<I>",
+            [&]() {
+                vecex::compute(
+                        std::array { a.data(), b.data(), result.data() },
+                        SIZE,
+                        []( auto& ctx ) {
+                            auto a = vecex::load<0>( ctx );
+                            auto b = vecex::load<1>( ctx );
+                            vecex::store<2>( ctx, a + b );
+                        } );
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Dispatch",
+            [&]() {
+                vecex::dispatch::add(
+                        a.data(), b.data(), result.data(), SIZE );
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+}
+
+// every run allocates fresh pages, std::vector zero fills them before the
+// kernel writes, default_init_vector only writes once
+void
+bench_alloc() {
+    std::vector<TYPE> a( PARALLEL_SIZE );
+    std::vector<TYPE> b( PARALLEL_SIZE );
+    for ( size_t i = 0; i < PARALLEL_SIZE; i++ ) {
+        a[i] = i;
+        b[i] = i;
+    }
+    ankerl::nanobench::Rng().shuffle( a );
+    ankerl::nanobench::Rng().shuffle( b );
+    vecex::default_init_vector<TYPE> a_init( a.begin(), a.end() );
+    vecex::default_init_vector<TYPE> b_init( b.begin(), b.end() );
+
+    ankerl::nanobench::Bench bench;
+    bench.minEpochIterations( PARALLEL_MINIT )
+            .batch( PARALLEL_SIZE )
+            .unit( "element" );
+    bench.run( "Alloc vecex::add std::vector", [&]() {
+        auto c = vecex::add( a, b );
+        ankerl::nanobench::doNotOptimizeAway( c );
+    } );
+    bench.run( "Alloc vecex::add default_init_vector", [&]() {
+        auto c = vecex::add( a_init, b_init );
+        ankerl::nanobench::doNotOptimizeAway( c );
+    } );
+    bench.run( "Alloc Vector Override std::vector", [&]() {
+        std::vector<TYPE> c = a + b;
+        ankerl::nanobench::doNotOptimizeAway( c );
+    } );
+    bench.run( "Alloc Vector Override default_init_vector", [&]() {
+        vecex::default_init_vector<TYPE> c = a + b;
+        ankerl::nanobench::doNotOptimizeAway( c );
+    } );
+}
+
+// the vectors have to be vecex::vector: store_stream only streams to data
+// aligned to the native simd register and doesn't peel to the first aligned
+// element, a std::vector would fall back to normal stores
+void
+bench_stream() {
+    vecex::vector<TYPE> a( STREAM_SIZE );
+    vecex::vector<TYPE> b( STREAM_SIZE );
+    vecex::vector<TYPE> result( STREAM_SIZE );
+    for ( size_t i = 0; i < STREAM_SIZE; i++ ) {
+        a[i] = i;
+        b[i] = i;
+        result[i] = 0;
+    }
+
+    ankerl::nanobench::Bench bench;
+    bench.minEpochIterations( PARALLEL_MINIT )
+            .batch( STREAM_SIZE )
+            .unit( "element" );
+    bench.run( "Stream store", [&]() {
+        vecex::compute( std::array { a.data(), b.data(), result.data() },
+                        STREAM_SIZE,
+                        []( auto& ctx ) {
+                            auto c = ctx.load( 0 ) * ctx.load( 1 );
+                            ctx.store( c, 2 );
+                        } );
+        ankerl::nanobench::doNotOptimizeAway( result );
+    } );
+    bench.run( "Stream store_stream", [&]() {
+        vecex::compute( std::array { a.data(), b.data(), result.data() },
+                        STREAM_SIZE,
+                        []( auto& ctx ) {
+                            auto c = ctx.load( 0 ) * ctx.load( 1 );
+                            ctx.store_stream( c, 2 );
+                        } );
+        ankerl::nanobench::doNotOptimizeAway( result );
+    } );
+    bench.run( "Stream vecex::out", [&]() {
+        vecex::compute( std::tuple { vecex::in( a.data() ),
+                                     vecex::in( b.data() ),
+                                     vecex::out( result.data() ) },
+                        STREAM_SIZE,
+                        []( auto& ctx ) {
+                            auto c = vecex::load<0>( ctx )
+                                     * vecex::load<1>( ctx );
+                            vecex::store<2>( ctx, c );
+                        } );
+        ankerl::nanobench::doNotOptimizeAway( result );
+    } );
+}
+
+// the complex kernel with 6 data sets
+template<class Policy>
+void
+bench_complex_policy( const std::string&                name,
+                      std::array<std::vector<TYPE>, 6>& data,
+                      const size_t                      size ) {
+    ankerl::nanobench::Bench().minEpochIterations( 10 ).batch( size ).run(
+            name + " " + std::to_string( size ),
+            [&]() {
+                vecex::compute(
+                        std::array { data[0].data(),
+                                     data[1].data(),
+                                     data[2].data(),
+                                     data[3].data(),
+                                     data[4].data(),
+                                     data[5].data() },
+                        size,
+                        []( auto& ctx ) {
+                            auto a = ctx.load( 0 );
+                            auto b = ctx.load( 1 );
+                            auto c = a + b;
+                            auto d = b + c;
+                            auto e = c * b;
+                            auto f = d * b;
+                            auto an = f - TYPE( 3 );
+                            f = d - an;
+                            ctx.store( an, 0 );
+                            ctx.store( c, 2 );
+                            ctx.store( d, 3 );
+                            ctx.store( e, 4 );
+                            ctx.store( f, 5 );
+                        },
+                        Policy {} );
+                ankerl::nanobench::doNotOptimizeAway( data );
+            } );
+}
+
+// sized for L2, L3 and DRAM
+void
+bench_prefetch() {
+    // 6 x 64 KiB, 6 x 2 MiB, 6 x 64 MiB
+    for ( size_t size : { 1 << 14, 1 << 19, 1 << 24 } ) {
+        std::array<std::vector<TYPE>, 6> data;
+        for ( auto& data_set : data ) {
+            data_set.resize( size );
+            for ( size_t i = 0; i < size; i++ ) {
+                data_set[i] = i % 100;
+            }
+        }
+
+        bench_complex_policy<vecex::policy<>>( "Prefetch off", data, size );
+        bench_complex_policy<vecex::policy<>::with_prefetch<256>>(
+                "Prefetch 256", data, size );
+        bench_complex_policy<vecex::policy<>::with_prefetch<1024>>(
+                "Prefetch 1024", data, size );
+        bench_complex_policy<vecex::policy<>::with_prefetch<4096>>(
+                "Prefetch 4096", data, size );
+    }
+}
+
+// SIZE stays in the cache, so the dependency chain of the kernel and not the
+// memory bandwidth limits it
+void
+bench_interleave() {
+    std::array<std::vector<TYPE>, 6> data;
+    for ( auto& data_set : data ) {
+        data_set.resize( SIZE );
+        for ( size_t i = 0; i < SIZE; i++ ) {
+            data_set[i] = i % 100;
+        }
+    }
+
+    bench_complex_policy<vecex::policy<>>( "Interleave 1", data, SIZE );
+    bench_complex_policy<vecex::policy<>::with_interleave<2>>(
+            "Interleave 2", data, SIZE );
+    bench_complex_policy<vecex::policy<>::with_interleave<4>>(
+            "Interleave 4", data, SIZE );
+    bench_complex_policy<vecex::policy<>::with_interleave<8>>(
+            "Interleave 8", data, SIZE );
 }
 
 void
@@ -139,6 +365,19 @@ bench_complex() {
                 ankerl::nanobench::doNotOptimizeAway( f );
             } );
 
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Complex Vector Override chained",
+            [&]() {
+                // c and d inlined, every line is a single pass
+                vecex::assign( e, ( a + b ) * b );
+                vecex::assign( f, ( b + ( a + b ) ) * b );
+                vecex::assign( a, f - TYPE( 3 ) );
+                ankerl::nanobench::doNotOptimizeAway( a );
+                ankerl::nanobench::doNotOptimizeAway( b );
+                ankerl::nanobench::doNotOptimizeAway( e );
+                ankerl::nanobench::doNotOptimizeAway( f );
+            } );
+
     ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
             "Complex Vector IN",
             [&]() {
@@ -189,6 +428,40 @@ bench_complex() {
                 ankerl::nanobench::doNotOptimizeAway( f );
             } );
 
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Complex compute tagged",
+            [&]() {
+                vecex::compute(
+                        std::tuple { vecex::inout( a.data() ),
+                                     vecex::in( b.data() ),
+                                     vecex::out( c.data() ),
+                                     vecex::out( d.data() ),
+                                     vecex::out( e.data() ),
+                                     vecex::out( f.data() ) },
+                        SIZE,
+                        []( auto& ctx ) {
+                            auto a = vecex::load<0>( ctx );
+                            auto b = vecex::load<1>( ctx );
+                            auto c = a + b;
+                            auto d = b + c;
+                            auto e = c * b;
+                            auto f = d * b;
+                            auto an = f - TYPE( 3 );
+                            f = d - an;
+                            vecex::store<0>( ctx, an );
+                            vecex::store<2>( ctx, c );
+                            vecex::store<3>( ctx, d );
+                            vecex::store<4>( ctx, e );
+                            vecex::store<5>( ctx, f );
+                        } );
+                ankerl::nanobench::doNotOptimizeAway( a );
+                ankerl::nanobench::doNotOptimizeAway( b );
+                ankerl::nanobench::doNotOptimizeAway( c );
+                ankerl::nanobench::doNotOptimizeAway( d );
+                ankerl::nanobench::doNotOptimizeAway( e );
+                ankerl::nanobench::doNotOptimizeAway( f );
+            } );
+
     ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
             "Complex compute only store e,f",
             [&]() {
@@ -221,6 +494,806 @@ bench_complex() {
             } );
 }
 
+void
+bench_tail() {
+    for ( size_t size : { 7, 31, 100, 1003, 10007, 100003 } ) {
+        std::vector<TYPE> a( size );
+        std::vector<TYPE> b( size );
+        std::vector<TYPE> result( size );
+        for ( size_t i = 0; i < size; i++ ) {
+            a[i] = i;
+            b[i] = i;
+        }
+        vecex::vector<TYPE> a_padded( a.begin(), a.end() );
+        vecex::vector<TYPE> b_padded( b.begin(), b.end() );
+        vecex::vector<TYPE> result_padded( size );
+
+        ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+                "Tail cascade " + std::to_string( size ),
+                [&]() {
+                    vecex::compute(
+                            std::array { a.data(), b.data(), result.data() },
+                            size,
+                            []( auto& ctx ) {
+                                auto c = ctx.load( 0 ) + ctx.load( 1 );
+                                ctx.store( c, 2 );
+                            } );
+                    ankerl::nanobench::doNotOptimizeAway( result );
+                } );
+        ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+                "Tail masked " + std::to_string( size ),
+                [&]() {
+                    vecex::compute(
+                            std::array { a.data(), b.data(), result.data() },
+                            size,
+                            []( auto& ctx ) {
+                                auto c = ctx.load( 0 ) + ctx.load( 1 );
+                                ctx.store( c, 2 );
+                            },
+                            vecex::policy<>::with_tail<
+                                    vecex::tail_mode::masked> {} );
+                    ankerl::nanobench::doNotOptimizeAway( result );
+                } );
+        ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+                "Tail padded " + std::to_string( size ),
+                [&]() {
+                    vecex::compute(
+                            std::array { a_padded.data(),
+                                         b_padded.data(),
+                                         result_padded.data() },
+                            size,
+                            []( auto& ctx ) {
+                                auto c = ctx.load( 0 ) + ctx.load( 1 );
+                                ctx.store( c, 2 );
+                            },
+                            vecex::policy<>::with_tail<
+                                    vecex::tail_mode::padded> {} );
+                    ankerl::nanobench::doNotOptimizeAway( result_padded );
+                } );
+    }
+}
+
+void
+bench_reduce() {
+    std::vector<TYPE> a( SIZE );
+    std::vector<TYPE> b( SIZE );
+    std::vector<TYPE> c( SIZE );
+    for ( int i = 0; i < SIZE; i++ ) {
+        a[i] = i % 100;
+        b[i] = 1;
+    }
+
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Reduce Normal",
+            [&]() {
+                TYPE sum = 0;
+                for ( size_t i = 0; i < SIZE; i++ ) {
+                    c[i] = a[i] * b[i];
+                    sum += c[i];
+                }
+                ankerl::nanobench::doNotOptimizeAway( sum );
+                ankerl::nanobench::doNotOptimizeAway( c );
+            } );
+
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Reduce compute + Normal sum",
+            [&]() {
+                vecex::compute(
+                        std::array { a.data(), b.data(), c.data() },
+                        SIZE,
+                        []( auto& ctx ) {
+                            auto c = ctx.load( 0 ) * ctx.load( 1 );
+                            ctx.store( c, 2 );
+                        } );
+                TYPE sum = 0;
+                for ( size_t i = 0; i < SIZE; i++ ) {
+                    sum += c[i];
+                }
+                ankerl::nanobench::doNotOptimizeAway( sum );
+                ankerl::nanobench::doNotOptimizeAway( c );
+            } );
+
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Reduce compute_reduce",
+            [&]() {
+                auto sum = vecex::compute_reduce<vecex::reduce_sum>(
+                        std::array { a.data(), b.data(), c.data() },
+                        SIZE,
+                        []( auto& ctx ) {
+                            auto c = ctx.load( 0 ) * ctx.load( 1 );
+                            ctx.store( c, 2 );
+                            ctx.accumulate( c, 0 );
+                        } );
+                ankerl::nanobench::doNotOptimizeAway( sum );
+                ankerl::nanobench::doNotOptimizeAway( c );
+            } );
+}
+
+// polynomial in horner form, every step is a multiplication followed by an
+// addition, which compute fuses into mul_add
+void
+bench_fma() {
+    std::vector<TYPE> x( SIZE );
+    std::vector<TYPE> y( SIZE );
+    std::vector<TYPE> result( SIZE );
+    for ( int i = 0; i < SIZE; i++ ) {
+        x[i] = TYPE( i % 100 ) / TYPE( 100 );
+        y[i] = TYPE( i % 10 );
+    }
+    const TYPE c0 = 1, c1 = 0.5, c2 = 0.25, c3 = 0.125, c4 = 0.0625;
+
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "FMA Normal horner",
+            [&]() {
+                for ( size_t i = 0; i < SIZE; i++ ) {
+                    result[i] = (((c4 * x[i] + c3) * x[i] + c2) * x[i] + c1)
+                                        * x[i]
+                                + c0;
+                }
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "FMA compute horner",
+            [&]() {
+                vecex::compute(
+                        std::array { x.data(), result.data() },
+                        SIZE,
+                        [&]( auto& ctx ) {
+                            auto x = ctx.load( 0 );
+                            auto p = x * c4 + c3;
+                            p = p * x + c2;
+                            p = p * x + c1;
+                            p = p * x + c0;
+                            ctx.store( p, 1 );
+                        } );
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "FMA Normal axpy",
+            [&]() {
+                for ( size_t i = 0; i < SIZE; i++ ) {
+                    result[i] = c1 * x[i] + y[i];
+                }
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "FMA compute axpy",
+            [&]() {
+                vecex::compute(
+                        std::array { x.data(), y.data(), result.data() },
+                        SIZE,
+                        [&]( auto& ctx ) {
+                            ctx.store( ctx.load( 0 ) * c1 + ctx.load( 1 ), 2 );
+                        } );
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+}
+
+// bucketing int ids by a runtime divisor
+void
+bench_int_div() {
+    std::vector<int> ids( SIZE );
+    std::vector<int> buckets( SIZE );
+    for ( int i = 0; i < SIZE; i++ ) {
+        ids[i] = i * 7919;
+    }
+    int bucket_size = 37;
+    ankerl::nanobench::doNotOptimizeAway( bucket_size );
+
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "IntDiv Normal",
+            [&]() {
+                for ( size_t i = 0; i < SIZE; i++ ) {
+                    buckets[i] = ids[i] / bucket_size;
+                }
+                ankerl::nanobench::doNotOptimizeAway( buckets );
+            } );
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "IntDiv vecex::div_in",
+            [&]() {
+                vecex::div_in( ids, bucket_size, buckets );
+                ankerl::nanobench::doNotOptimizeAway( buckets );
+            } );
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "IntDiv compute divisor",
+            [&]() {
+                vecex::divisor<int> d( bucket_size );
+                vecex::compute( std::array { ids.data(), buckets.data() },
+                                SIZE,
+                                [d]( auto& ctx ) {
+                                    ctx.store( ctx.load( 0 ) / d, 1 );
+                                } );
+                ankerl::nanobench::doNotOptimizeAway( buckets );
+            } );
+}
+
+// clamp to [10, 90] and a piecewise function, branchy scalar against masks
+void
+bench_select() {
+    std::vector<TYPE> a( SIZE );
+    std::vector<TYPE> result( SIZE );
+    for ( int i = 0; i < SIZE; i++ ) {
+        a[i] = i % 100;
+    }
+    ankerl::nanobench::Rng().shuffle( a );
+
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Select Normal",
+            [&]() {
+                for ( size_t i = 0; i < SIZE; i++ ) {
+                    TYPE x = a[i] < 10 ? 10 : ( a[i] > 90 ? 90 : a[i] );
+                    if ( x > 50 ) {
+                        x = x * 2 - 50;
+                    }
+                    result[i] = x;
+                }
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Select compute",
+            [&]() {
+                vecex::compute( std::array { a.data(), result.data() },
+                                SIZE,
+                                []( auto& ctx ) {
+                                    auto x = ctx.load( 0 );
+                                    x = vecex::select( x < TYPE( 10 ), 10, x );
+                                    x = vecex::select( x > TYPE( 90 ), 90, x );
+                                    x = vecex::select(
+                                            x > TYPE( 50 ), x * 2 - 50, x );
+                                    ctx.store( x, 1 );
+                                } );
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+}
+
+// about 1% of the elements get updated
+void
+bench_store_if() {
+    std::vector<TYPE> a( SIZE );
+    std::vector<TYPE> result( SIZE );
+    for ( int i = 0; i < SIZE; i++ ) {
+        a[i] = i % 100;
+    }
+    ankerl::nanobench::Rng().shuffle( a );
+
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "StoreIf Normal",
+            [&]() {
+                for ( size_t i = 0; i < SIZE; i++ ) {
+                    if ( a[i] > 98 ) {
+                        result[i] = a[i] * 2;
+                    }
+                }
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "StoreIf compute select",
+            [&]() {
+                vecex::compute( std::array { a.data(), result.data() },
+                                SIZE,
+                                []( auto& ctx ) {
+                                    auto a = ctx.load( 0 );
+                                    auto old = ctx.load( 1 );
+                                    ctx.store( vecex::select(
+                                                       a > TYPE( 98 ),
+                                                       a * 2,
+                                                       old ),
+                                               1 );
+                                } );
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "StoreIf compute store_if",
+            [&]() {
+                vecex::compute( std::array { a.data(), result.data() },
+                                SIZE,
+                                []( auto& ctx ) {
+                                    auto a = ctx.load( 0 );
+                                    ctx.store_if( a > TYPE( 98 ), a * 2, 1 );
+                                } );
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+}
+
+// keeps about half of the elements, the worst case for the branch
+void
+bench_filter() {
+    std::vector<TYPE> a( SIZE );
+    std::vector<TYPE> result( SIZE );
+    for ( int i = 0; i < SIZE; i++ ) {
+        a[i] = i % 100;
+    }
+    ankerl::nanobench::Rng().shuffle( a );
+
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Filter Normal",
+            [&]() {
+                size_t count = 0;
+                for ( size_t i = 0; i < SIZE; i++ ) {
+                    if ( a[i] > 49 ) {
+                        result[count++] = a[i];
+                    }
+                }
+                ankerl::nanobench::doNotOptimizeAway( count );
+            } );
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Filter compute emit",
+            [&]() {
+                auto counts = vecex::compute(
+                        std::array { a.data(), result.data() },
+                        SIZE,
+                        []( auto& ctx ) {
+                            auto a = ctx.load( 0 );
+                            ctx.emit( a > TYPE( 49 ), a, 1 );
+                        } );
+                ankerl::nanobench::doNotOptimizeAway( counts );
+            } );
+}
+
+// moving average over 2 * R + 1 taps. the scalar loop and edge_mode::skip
+// only compute the inner range
+template<int R>
+void
+bench_stencil_taps( std::vector<TYPE>& a, std::vector<TYPE>& result ) {
+    const std::string taps = std::to_string( 2 * R + 1 ) + " tap";
+    const TYPE        weight = TYPE( 1 ) / ( 2 * R + 1 );
+
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Stencil Normal " + taps,
+            [&]() {
+                for ( size_t i = R; i < SIZE - R; i++ ) {
+                    TYPE sum = 0;
+                    for ( int k = -R; k <= R; k++ ) {
+                        sum += a[i + k];
+                    }
+                    result[i] = sum * weight;
+                }
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Stencil compute clamp " + taps,
+            [&]() {
+                vecex::compute( std::array { a.data(), result.data() },
+                                SIZE,
+                                [weight]( auto& ctx ) {
+                                    auto sum = ctx.load( 0, -R );
+                                    for ( int k = -R + 1; k <= R; k++ ) {
+                                        sum = sum + ctx.load( 0, k );
+                                    }
+                                    ctx.store( sum * weight, 1 );
+                                } );
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Stencil compute skip " + taps,
+            [&]() {
+                vecex::compute(
+                        std::array { a.data() + R, result.data() + R },
+                        SIZE - 2 * R,
+                        [weight]( auto& ctx ) {
+                            const auto SKIP = vecex::edge_mode::skip;
+                            auto       sum = ctx.load( 0, -R, SKIP );
+                            for ( int k = -R + 1; k <= R; k++ ) {
+                                sum = sum + ctx.load( 0, k, SKIP );
+                            }
+                            ctx.store( sum * weight, 1 );
+                        } );
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+}
+
+void
+bench_stencil() {
+    std::vector<TYPE> a( SIZE );
+    std::vector<TYPE> result( SIZE );
+    for ( int i = 0; i < SIZE; i++ ) {
+        a[i] = i % 100;
+    }
+
+    bench_stencil_taps<1>( a, result );
+    bench_stencil_taps<2>( a, result );
+    bench_stencil_taps<3>( a, result );
+}
+
+// table[index[i]] with a sequential and a random index stream
+void
+bench_gather_indices( const std::string& name, std::vector<int>& index ) {
+    std::vector<TYPE> table( SIZE );
+    std::vector<TYPE> result( SIZE );
+    for ( int i = 0; i < SIZE; i++ ) {
+        table[i] = i % 100;
+    }
+
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Gather Normal " + name,
+            [&]() {
+                for ( size_t i = 0; i < SIZE; i++ ) {
+                    result[i] = table[index[i]];
+                }
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Gather compute " + name,
+            [&]() {
+                vecex::compute( std::tuple { index.data(), result.data() },
+                                SIZE,
+                                [&]( auto& ctx ) {
+                                    auto i = vecex::load<0>( ctx );
+                                    vecex::store<1>(
+                                            ctx,
+                                            ctx.gather( table.data(), i ) );
+                                } );
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+}
+
+void
+bench_gather() {
+    std::vector<int> index( SIZE );
+    for ( int i = 0; i < SIZE; i++ ) {
+        index[i] = i;
+    }
+    bench_gather_indices( "sequential", index );
+    ankerl::nanobench::Rng().shuffle( index );
+    bench_gather_indices( "random", index );
+}
+
+// result[index[i]] = a[i] with a random permutation
+void
+bench_scatter() {
+    std::vector<int>  index( SIZE );
+    std::vector<TYPE> a( SIZE );
+    std::vector<TYPE> result( SIZE );
+    for ( int i = 0; i < SIZE; i++ ) {
+        index[i] = i;
+        a[i] = i % 100;
+    }
+    ankerl::nanobench::Rng().shuffle( index );
+
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Scatter Normal",
+            [&]() {
+                for ( size_t i = 0; i < SIZE; i++ ) {
+                    result[index[i]] = a[i];
+                }
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Scatter compute",
+            [&]() {
+                vecex::compute( std::tuple { index.data(), a.data() },
+                                SIZE,
+                                [&]( auto& ctx ) {
+                                    ctx.scatter( result.data(),
+                                                 vecex::load<0>( ctx ),
+                                                 vecex::load<1>( ctx ) );
+                                } );
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+}
+
+// a * 2 + 1 over a file of STREAM_SIZE floats: read() into a vector first vs
+// computing directly on the mapping vs streaming it in chunks
+void
+bench_mapped() {
+    const std::string path
+            = ( std::filesystem::temp_directory_path() / "vecex_bench.bin" )
+                      .string();
+    {
+        vecex::mapped_array<TYPE> file( path, STREAM_SIZE );
+        for ( size_t i = 0; i < STREAM_SIZE; i++ ) {
+            file[i] = i % 100;
+        }
+    }
+    std::vector<TYPE> result( STREAM_SIZE );
+
+    ankerl::nanobench::Bench bench;
+    bench.minEpochIterations( PARALLEL_MINIT )
+            .batch( STREAM_SIZE )
+            .unit( "element" );
+    bench.run( "Mapped read + compute", [&]() {
+        std::vector<TYPE> a( STREAM_SIZE );
+        const size_t      total = STREAM_SIZE * sizeof( TYPE );
+        const int         fd = ::open( path.c_str(), O_RDONLY );
+        size_t            done = 0;
+        while ( done < total ) {
+            const ssize_t bytes
+                    = ::read( fd, (char*)a.data() + done, total - done );
+            if ( bytes <= 0 ) {
+                break;
+            }
+            done += bytes;
+        }
+        ::close( fd );
+        vecex::compute( std::array { a.data(), result.data() },
+                        STREAM_SIZE,
+                        []( auto& ctx ) {
+                            ctx.store( ctx.load( 0 ) * TYPE( 2 ) + TYPE( 1 ),
+                                       1 );
+                        } );
+        ankerl::nanobench::doNotOptimizeAway( result );
+    } );
+    bench.run( "Mapped compute_mapped", [&]() {
+        vecex::mapped_array<TYPE> a( path );
+        vecex::compute_mapped( std::array { a.data(), result.data() },
+                               STREAM_SIZE,
+                               []( auto& ctx ) {
+                                   ctx.store( ctx.load( 0 ) * TYPE( 2 )
+                                                      + TYPE( 1 ),
+                                              1 );
+                               } );
+        ankerl::nanobench::doNotOptimizeAway( result );
+    } );
+    bench.run( "Mapped compute_stream", [&]() {
+        const int fd = ::open( path.c_str(), O_RDONLY );
+        TYPE*     out = result.data();
+        vecex::compute_stream<TYPE>(
+                std::tuple { vecex::stream::from_fd( fd ),
+                             vecex::stream::output(
+                                     [&]( const TYPE* data, size_t count ) {
+                                         std::copy(
+                                                 data, data + count, out );
+                                         out += count;
+                                     } ) },
+                []( auto& ctx ) {
+                    ctx.store( ctx.load( 0 ) * TYPE( 2 ) + TYPE( 1 ), 1 );
+                } );
+        ::close( fd );
+        ankerl::nanobench::doNotOptimizeAway( result );
+    } );
+
+    std::remove( path.c_str() );
+}
+
+// largest relative error of a compute math kernel against libm in double
+template<class Kernel, class Reference>
+void
+bench_math_run( const std::string& name,
+                std::vector<TYPE>& a,
+                std::vector<TYPE>& result,
+                Kernel                   kernel,
+                Reference                reference ) {
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Math Normal " + name,
+            [&]() {
+                for ( size_t i = 0; i < SIZE; i++ ) {
+                    result[i] = reference( a[i] );
+                }
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Math compute " + name,
+            [&]() {
+                vecex::compute( std::array { a.data(), result.data() },
+                                SIZE,
+                                [&]( auto& ctx ) {
+                                    ctx.store( kernel( ctx.load( 0 ) ), 1 );
+                                } );
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+
+    double max_error = 0;
+    for ( size_t i = 0; i < SIZE; i++ ) {
+        const double expected = reference( (double)a[i] );
+        const double error = std::abs( ( result[i] - expected ) / expected );
+        max_error = error > max_error ? error : max_error;
+    }
+    std::printf( "Math accuracy %s: max relative error %g\n",
+                 name.c_str(),
+                 max_error );
+}
+
+void
+bench_math() {
+    std::vector<TYPE> a( SIZE );
+    std::vector<TYPE> result( SIZE );
+    for ( int i = 0; i < SIZE; i++ ) {
+        a[i] = TYPE( 0.001 ) + TYPE( i % 1000 ) / TYPE( 100 );
+    }
+
+    bench_math_run(
+            "sqrt",
+            a,
+            result,
+            []( auto v ) { return v.sqrt(); },
+            []( auto x ) { return std::sqrt( x ); } );
+    bench_math_run(
+            "exp",
+            a,
+            result,
+            []( auto v ) { return v.exp(); },
+            []( auto x ) { return std::exp( x ); } );
+    bench_math_run(
+            "log",
+            a,
+            result,
+            []( auto v ) { return v.log(); },
+            []( auto x ) { return std::log( x ); } );
+    bench_math_run(
+            "sin",
+            a,
+            result,
+            []( auto v ) { return v.sin(); },
+            []( auto x ) { return std::sin( x ); } );
+    bench_math_run(
+            "cos",
+            a,
+            result,
+            []( auto v ) { return v.cos(); },
+            []( auto x ) { return std::cos( x ); } );
+    bench_math_run(
+            "tan",
+            a,
+            result,
+            []( auto v ) { return v.tan(); },
+            []( auto x ) { return std::tan( x ); } );
+    bench_math_run(
+            "tanh",
+            a,
+            result,
+            []( auto v ) { return v.tanh(); },
+            []( auto x ) { return std::tanh( x ); } );
+    bench_math_run(
+            "pow",
+            a,
+            result,
+            []( auto v ) { return v.pow( TYPE( 1.5 ) ); },
+            []( auto x ) { return std::pow( x, decltype( x )( 1.5 ) ); } );
+}
+
+void
+bench_mixed() {
+    std::vector<unsigned char> mask( SIZE );
+    std::vector<TYPE>          values( SIZE );
+    std::vector<TYPE>          mask_converted( SIZE );
+    std::vector<TYPE>          result( SIZE );
+    for ( int i = 0; i < SIZE; i++ ) {
+        mask[i] = i % 3 == 0;
+        values[i] = i;
+    }
+
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Mixed Normal",
+            [&]() {
+                for ( size_t i = 0; i < SIZE; i++ ) {
+                    result[i] = values[i] * mask[i];
+                }
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Mixed convert + compute",
+            [&]() {
+                for ( size_t i = 0; i < SIZE; i++ ) {
+                    mask_converted[i] = mask[i];
+                }
+                vecex::compute(
+                        std::array { values.data(),
+                                     mask_converted.data(),
+                                     result.data() },
+                        SIZE,
+                        []( auto& ctx ) {
+                            auto c = ctx.load( 0 ) * ctx.load( 1 );
+                            ctx.store( c, 2 );
+                        } );
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Mixed compute",
+            [&]() {
+                vecex::compute(
+                        std::tuple { mask.data(),
+                                     values.data(),
+                                     result.data() },
+                        SIZE,
+                        []( auto& ctx ) {
+                            auto mask = vecex::convert<TYPE>(
+                                    vecex::load<0>( ctx ) );
+                            auto c = vecex::load<1>( ctx ) * mask;
+                            vecex::store<2>( ctx, c );
+                        } );
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+
+    // the same kernel with the mask converted lane by lane, the difference
+    // to "Mixed compute" is the extend_low / extend_high + to_float path
+    ankerl::nanobench::Bench().minEpochIterations( MINIT ).run(
+            "Mixed compute lane convert",
+            [&]() {
+                vecex::compute(
+                        std::tuple { mask.data(),
+                                     values.data(),
+                                     result.data() },
+                        SIZE,
+                        []( auto& ctx ) {
+                            auto values = vecex::load<1>( ctx );
+                            auto lanes = vecex::load<0>( ctx );
+                            const size_t  N = sizeof( lanes.value );
+                            unsigned char from[N];
+                            TYPE          to[N];
+                            lanes.store( from );
+                            for ( size_t i = 0; i < N; i++ ) {
+                                to[i] = from[i];
+                            }
+                            auto c = values * decltype( values )::load( to );
+                            vecex::store<2>( ctx, c );
+                        } );
+                ankerl::nanobench::doNotOptimizeAway( result );
+            } );
+}
+
+void
+bench_parallel() {
+    std::vector<TYPE> a( PARALLEL_SIZE );
+    std::vector<TYPE> b( PARALLEL_SIZE );
+    std::vector<TYPE> c( PARALLEL_SIZE );
+    std::vector<TYPE> d( PARALLEL_SIZE );
+    std::vector<TYPE> e( PARALLEL_SIZE );
+    std::vector<TYPE> f( PARALLEL_SIZE );
+
+    for ( int i = 0; i < PARALLEL_SIZE; i++ ) {
+        a[i] = i;
+        b[i] = i;
+    }
+
+    const size_t max_threads = std::thread::hardware_concurrency();
+    for ( size_t threads = 1; threads <= max_threads; threads *= 2 ) {
+        ankerl::nanobench::Bench().minEpochIterations( PARALLEL_MINIT ).run(
+                "Compute parallel " + std::to_string( threads ),
+                [&]() {
+                    vecex::compute_parallel(
+                            std::array { a.data(), b.data(), c.data() },
+                            PARALLEL_SIZE,
+                            []( auto& ctx ) {
+                                auto a = ctx.load( 0 );
+                                auto b = ctx.load( 1 );
+                                auto c = a + b;
+                                ctx.store( c, 2 );
+                            },
+                            threads );
+                    ankerl::nanobench::doNotOptimizeAway( c );
+                } );
+    }
+
+    for ( size_t threads = 1; threads <= max_threads; threads *= 2 ) {
+        ankerl::nanobench::Bench().minEpochIterations( PARALLEL_MINIT ).run(
+                "Complex compute parallel " + std::to_string( threads ),
+                [&]() {
+                    vecex::compute_parallel(
+                            std::array { a.data(),
+                                         b.data(),
+                                         c.data(),
+                                         d.data(),
+                                         e.data(),
+                                         f.data() },
+                            PARALLEL_SIZE,
+                            []( auto& ctx ) {
+                                auto a = ctx.load( 0 );
+                                auto b = ctx.load( 1 );
+                                auto c = a + b;
+                                auto d = b + c;
+                                auto e = c * b;
+                                auto f = d * b;
+                                auto an = f - TYPE( 3 );
+                                f = d - an;
+                                ctx.store( an, 0 );
+                                ctx.store( c, 2 );
+                                ctx.store( d, 3 );
+                                ctx.store( e, 4 );
+                                ctx.store( f, 5 );
+                            },
+                            threads );
+                    ankerl::nanobench::doNotOptimizeAway( a );
+                    ankerl::nanobench::doNotOptimizeAway( c );
+                    ankerl::nanobench::doNotOptimizeAway( d );
+                    ankerl::nanobench::doNotOptimizeAway( e );
+                    ankerl::nanobench::doNotOptimizeAway( f );
+                } );
+    }
+}
+
 void
 testing() {
     std::vector<TYPE> a;
@@ -273,7 +1346,25 @@ testing() {
 int
 main() {
     bench1();
+    bench_alloc();
+    bench_stream();
+    bench_mapped();
     bench_complex();
+    bench_prefetch();
+    bench_interleave();
+    bench_tail();
+    bench_reduce();
+    bench_mixed();
+    bench_math();
+    bench_fma();
+    bench_int_div();
+    bench_select();
+    bench_store_if();
+    bench_filter();
+    bench_stencil();
+    bench_gather();
+    bench_scatter();
+    bench_parallel();
     // testing();
     return 0;
 }
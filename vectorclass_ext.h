@@ -32,9 +32,21 @@ https://github.com/vectorclass/version2.git
 if needed change the #include "vectorclass.h" to the correct one (target is the
 vectorclass.h from agnar)
 
+* PREDEFINE VECEX_NAMESPACE
+puts everything of the extension into the inline namespace
+vecex::VECEX_NAMESPACE (same idea as VCL_NAMESPACE of the vectorclass). usage
+stays vecex::..., but the symbols differ. required if one program contains
+code compiled for several instruction sets, see vectorclass_ext_dispatch.h.
+Don't combine it with VECEX_OVERRIDE, the operators are global.
+
 * PREDFINE VECEX_OVERRIDE
 required to activate the override for std::vector<number> operator overloading
-( std::vector<float> a , b;  auto c = a + b; )
+( std::vector<float> a , b;  std::vector<float> c = a + b; )
+the operators are lazy: a + b * c - 2 only builds an expression that is
+evaluated in a single pass when it is converted to a std::vector. don't keep
+it in an auto variable, it references its operands.
+-> vecex::assign(std::vector& result, expression)
+    evaluates into result and reuses its storage (no new allocation)
 
 * Functions for your use
 just hide the namespace internal. everything is left is safe to use
@@ -49,7 +61,24 @@ just hide the namespace internal. everything is left is safe to use
     Arg1 -> std::vector
     Arg2 -> std::vector or number
     Arg3 -> only with _in, std::vector for the result
-    return -> only without _in, a new std::vector with the result
+    return -> only without _in, a new std::vector with the result. it uses
+              the allocator of Arg1, with a vecex::default_init_vector the
+              result isn't zero filled before it's overwritten
+    also with pointers for memory that isn't a std::vector:
+    add( const T* a, const T* b or number, element_count )
+        -> vecex::default_init_vector<T>
+    add_in( const T* a, const T* b or number, T* result, element_count )
+
+-> vecex::vector<T>
+    std::vector<T> with 64 byte aligned storage padded to a multiple of 64
+    bytes and default-initialized elements. works with every std::vector
+    function, add / sub / mul / div skip the tail handling if every vector
+    is a vecex::vector
+
+-> vecex::default_init_vector<T>
+    std::vector<T, vecex::default_init_allocator<T>>. resize() and the size
+    constructor leave new elements uninitialized instead of writing 0, saves
+    a full write pass over memory that compute overwrites anyway
 
 -> compute
     Arg1 -> std::array with pointer to the first element of each collection
@@ -59,6 +88,78 @@ just hide the namespace internal. everything is left is safe to use
             Tipp: use vecex::helper::element_count_min( [all_your_vecs]&...) )
     Arg3 -> lambda& for the computation []( auto& ctx ){ your_computation }.
             For more details read the next Paragraph.
+    Arg4 -> vecex::policy<...>{}, optional compile time options:
+            with_tail<vecex::tail_mode::masked> handles the elements behind
+            the last full simd vector with a single partial load/store
+            instead of halving the simd size down to single elements.
+            Unused lanes of the partial vector are loaded as 0.
+            with_tail<vecex::tail_mode::padded> requires every data set to
+            be a vecex::vector (64 byte aligned, padded to 64 bytes). only
+            aligned full vectors are loaded/stored, the last one reaches
+            into the padding. element_count has to be the size of every
+            data set that is stored to, else the padding of the last vector
+            overwrites elements behind element_count.
+            with_prefetch<BYTES> prefetches every data set BYTES ahead of
+            the current position. helps kernels with many data sets in DRAM
+            (more streams than the hardware prefetcher tracks), e.g. 1024.
+            with_interleave<K> runs K independent simd blocks per step of
+            the main loop, so the out of order core can overlap the
+            dependency chains of a long kernel. reductions get K separate
+            accumulators. ignored by compute with mixed types.
+            options combine: vecex::policy<>::with_tail<...>::with_prefetch<..>
+    return -> std::array with the count of elements ctx.emit wrote to each
+              data set (0 for the others)
+
+-> compute with mixed types
+    Arg1 -> std::tuple with pointers of different element types
+            std::tuple {mask.data(), values.data(), result.data()}
+    Arg2 - Arg4 -> same as compute
+    All data sets use the same amount of lanes, the widest simd size of the
+    widest type (float + unsigned char => Vec16f + Vec16uc). The data set is
+    picked at compile time: vecex::load<I>(ctx) and vecex::store<I>(ctx, v)
+    (or ctx.template load<I>() / ctx.template store<I>(v)).
+    vecex::convert<T>(value) converts a value to another element type.
+    Between integers, from 8 / 16 bit integers and int to float / double,
+    from long to double and back it stays in simd registers (extend_low /
+    extend_high, compress, to_float / to_double, truncatei), e.g. an
+    unsigned char mask times float values. Other pairs (unsigned int to
+    float, ...) convert lane by lane.
+    The pointers can be tagged with their access: vecex::in(ptr) is only
+    loaded, vecex::out(ptr) only stored and vecex::inout(ptr) (same as the
+    plain pointer) both. A store to an in or a load from an out data set
+    doesn't compile. out data sets aren't prefetched and are stored
+    non-temporal (store_stream, same alignment rule) if the call moves more
+    than 16 MiB.
+        std::tuple { vecex::in(a.data()), vecex::out(c.data()) }
+
+-> compute_reduce<Ops...>
+    Arg1 - Arg4 -> same as compute
+    Ops -> the reductions, vecex::reduce_sum / reduce_min / reduce_max
+    return -> std::array with one reduced number per Op
+    Inside the lambda ctx.accumulate(value, slot) adds a value to the
+    reduction with the index slot in Ops. The lanes are accumulated in simd
+    vectors and only reduced to a single number at the end.
+
+        auto [sum, max] = vecex::compute_reduce<vecex::reduce_sum,
+                                                vecex::reduce_max>(
+            std::array {a.data(), b.data()}, a.size(),
+            []( auto& ctx ) {
+                auto a = ctx.load(0);
+                ctx.accumulate( a * ctx.load(1), 0 );
+                ctx.accumulate( a, 1 );
+            });
+
+-> compute_parallel
+    Arg1 - Arg3 -> same as compute
+    Arg4 -> thread_count, optional. 0 (default) uses all hardware threads
+    Arg5 -> policy, same as compute
+    The range gets split into one chunk per thread. The threads are started
+    once and reused by every call. Each thread works on its own copy of the
+    lambda, so the lambda must not write into shared captures. Small ranges
+    are computed on the calling thread only. An exception of the lambda is
+    rethrown on the calling thread after every thread finished. Called from
+    inside a running compute_parallel (or compute_stream) the chunks run one
+    after another on the current thread.
 
 
     computation in lambda:
@@ -73,22 +174,118 @@ just hide the namespace internal. everything is left is safe to use
         the Index in the data_set you set in vecex::comput(data_set,
         element_count, lambda).
 
+        * Neighbors >> ctx.load(index, element_offset, edge) <<
+        Loads the elements element_offset away from the current ones, e.g.
+        a 3 tap moving average:
+            ( ctx.load(0, -1) + ctx.load(0) + ctx.load(0, 1) ) / 3
+        edge (optional) decides what the elements outside of the data_set
+        are: vecex::edge_mode::clamp (default) the first / last element,
+        vecex::edge_mode::zero 0 and vecex::edge_mode::skip doesn't check
+        anything, compute only the inner range then (a.data() + R with
+        element_count - 2 * R). Only the vectors at the edges are checked
+        lane by lane. Don't store into a data_set that is loaded with an
+        offset, the neighbors would already be overwritten.
+
+        * Table lookups >> ctx.gather(table, index_value, table_size) <<
+        table[index] for every lane, index_value is a loaded value of an
+        integer data_set. With different element types use compute with
+        mixed types: std::tuple {idx.data(), out.data()} and
+            ctx.template store<1>( ctx.gather( table.data(),
+                                               ctx.template load<0>() ) )
+        32 bit indices into float / 32 bit tables and 64 bit indices into
+        double / 64 bit tables use the vectorclass lookup (AVX2 / AVX-512
+        gather), other combinations fetch lane by lane. table_size is
+        optional, debug builds (without NDEBUG) assert every index below it.
+
+        * Scattering >> ctx.scatter(base, index_value, value, table_size) <<
+        base[index] = value for every lane, the counterpart of gather with
+        the same index and type rules (vectorclass scatter, the AVX-512
+        scatter instructions or a store per lane). If indices repeat, the
+        element that comes last in the data_set wins.
+
         * Storing the value >> ctx.store(value, index_in_data_set) <<
         !!! Remeber without storing the data_set will stay untouched !!!
         The context allows you to store values in the data_set you want.
 
+        * Compile time index >> vecex::load<I>(ctx) / store<I>(ctx, value) <<
+        Same as ctx.load(I) / ctx.store(value, I) (or ctx.template load<I>()),
+        but the index is checked at compile time and the pointer is read
+        from a copy of the data_set pointers in the context instead of
+        through the state. No aliasing promise (restrict) is made, the data
+        sets may overlap like for ctx.load(I).
+
+        * Conditional storing >> ctx.store_if(mask, value, index) <<
+        Stores only the lanes where the mask (a comparison) is set, the other
+        elements of the data_set stay untouched. Uses masked stores with
+        AVX-512 and AVX2 (32/64 bit types), otherwise the old content is
+        blended in. Vectors without a set lane aren't touched at all, so
+        sparse updates don't write back the whole data_set.
+
+        * Filtering >> ctx.emit(mask, value, index) <<
+        Packs the lanes where the mask is set one after another into the
+        data_set index, starting at its first element. compute returns a
+        std::array with the emitted count of every data_set:
+            auto kept = vecex::compute( std::array {a.data(), out.data()},
+                a.size(), []( auto& ctx ) {
+                    auto a = ctx.load(0);
+                    ctx.emit( a > 0, a, 1 );
+                })[1];
+        The elements of out behind the count are undefined. out may be a
+        data_set that is loaded from (filter in place). Uses the AVX-512
+        compress store (8/16 bit types need VBMI2), with AVX2 a permutation
+        of 8 lane 32 bit vectors, otherwise the lanes one by one. Not
+        available in compute with mixed types, and it doesn't compile in
+        compute_parallel, compute_mapped and compute_stream (every chunk
+        would start at the first element).
+
+        * Streaming the value >> ctx.store_stream(value, index_in_data_set) <<
+        Same as store, but with a non-temporal store that bypasses the cache.
+        Only streams if the data set is aligned to the native simd register
+        (16 bytes SSE, 32 AVX, 64 AVX-512), otherwise it is a normal store.
+        There is no peeling to the first aligned element, so use a
+        vecex::vector (64 byte aligned); a std::vector is only 16 byte
+        aligned by malloc. Use it for outputs bigger than the last level cache
+        that aren't read right after compute, it keeps the inputs in the cache
+        and saves the read of the destination. compute fences the stores
+        before it returns.
+
 
     current supported Value Operations:
 
         Operation   |   supported types
         ------------|--------------------------------------
         +, -, *     | all types
-        /           | float, double || WIP: INTEGER
+        /           | all types. value / value of integers divides
+                    | lane by lane, x / 0 is undefined as for a
+                    | single int
+        / divisor   | vecex::divisor<T> d(7) outside of the lambda
+                    | calculates the Divisor (multiply + shift) only
+                    | once. integers divide by a number only with it,
+                    | 64 bit integers lane by lane
                     |
-        .pow(x)     | WIP
+        .sqrt()     | float, double
+        .exp()      | (vectorclass vectormath, the single
+        .log()      |  elements of the tail use std::)
+        .pow(x)     | x is a value or a number
         .sin()      |
         .cos()      |
         .tan()      |
+        .tanh()     |
+                    |
+        .mul_add(b,c)  | all types, this * b + c
+        .mul_sub(b,c)  | this * b - c
+        .nmul_add(b,c) | -(this * b) + c
+        a * b + c is fused into a single mul_add (float, double) if the
+        addition or subtraction directly uses the result of the *
+                    |
+        == != < <=  | all types, value with value or number. the
+        > >=        | result is a mask: & | ^ ~, .any(), .all()
+                    |
+        vecex::select(mask, a, b)   | per lane mask ? a : b (a or b can
+                                    | be a number)
+        vecex::if_add(mask, a, b)   | per lane mask ? a + b : a
+        vecex::if_sub(mask, a, b)   | per lane mask ? a - b : a
+        vecex::if_mul(mask, a, b)   | per lane mask ? a * b : a
 
     Example:
 
@@ -130,10 +327,284 @@ just hide the namespace internal. everything is left is safe to use
 // #define VECEX_OVERRIDE
 
 #include "vectorclass.h"
+#include "vectormath_exp.h"
+#include "vectormath_trig.h"
+#include "vectormath_hyp.h"
+#include <cmath>
 #include <vector>
+#include <memory>
+#include <new>
+#include <cstring>
+#include <cassert>
+#include <array>
 #include <limits>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <utility>
+#include <tuple>
+#include <type_traits>
 
 namespace vecex {
+
+#ifdef VECEX_NAMESPACE
+inline namespace VECEX_NAMESPACE {
+#endif
+
+#ifdef VCL_NAMESPACE
+using namespace VCL_NAMESPACE;
+#endif
+
+// how compute handles the elements behind the last full simd vector
+enum class tail_mode {
+    // halve the simd size down to single elements (default)
+    cascade,
+    // one partial load/store at the widest simd size
+    masked,
+    // every data set is 64 byte aligned and padded to the widest simd size
+    // (vecex::vector). only aligned full vectors, the last one reaches into
+    // the padding
+    padded
+};
+
+// what ctx.load( index, element_offset, edge ) returns for the elements in
+// front of the first and behind the last element of the data set
+enum class edge_mode {
+    // the first / last element
+    clamp,
+    // 0
+    zero,
+    // no check, the caller only computes the inner range
+    skip
+};
+
+// compile time options for compute. use the with_ aliases to change a single
+// option: vecex::policy<>::with_tail<vecex::tail_mode::masked>
+template<tail_mode TAIL = tail_mode::cascade,
+         size_t    PREFETCH = 0,
+         size_t    INTERLEAVE = 1>
+struct policy {
+    static const tail_mode tail = TAIL;
+    // bytes ahead of the current offset that get prefetched in every data
+    // set, 0 leaves it to the hardware prefetcher
+    static const size_t prefetch = PREFETCH;
+    // independent simd blocks per loop step of the main loop
+    static const size_t interleave = INTERLEAVE;
+    static_assert( INTERLEAVE > 0, "interleave needs at least one block" );
+
+    template<tail_mode NEW_TAIL>
+    using with_tail = policy<NEW_TAIL, PREFETCH, INTERLEAVE>;
+    template<size_t NEW_PREFETCH>
+    using with_prefetch = policy<TAIL, NEW_PREFETCH, INTERLEAVE>;
+    template<size_t NEW_INTERLEAVE>
+    using with_interleave = policy<TAIL, PREFETCH, NEW_INTERLEAVE>;
+};
+
+// how compute with mixed types uses a data set, see vecex::in / out / inout
+enum class access { in, out, inout };
+
+// a data set pointer tagged with its access
+template<class T, access ACCESS>
+struct data_set {
+    T* pointer;
+};
+
+// only loaded, stores are a compile error
+template<class T>
+inline data_set<T, access::in>
+in( const T* pointer ) {
+    return { const_cast<T*>( pointer ) };
+}
+
+// only stored, loads are a compile error. isn't prefetched and big calls
+// store it non-temporal
+template<class T>
+inline data_set<T, access::out>
+out( T* pointer ) {
+    return { pointer };
+}
+
+// loaded and stored, the same as the plain pointer
+template<class T>
+inline data_set<T, access::inout>
+inout( T* pointer ) {
+    return { pointer };
+}
+
+template<class CalcType>
+struct divisor;
+
+// allocator that default-initializes instead of value-initializes, a
+// std::vector<float> with it doesn't zero new elements on resize
+template<class T, class Base = std::allocator<T>>
+struct default_init_allocator : Base {
+    typedef std::allocator_traits<Base> base_traits;
+
+    template<class U>
+    struct rebind {
+        typedef default_init_allocator<
+                U,
+                typename base_traits::template rebind_alloc<U>>
+                other;
+    };
+
+    using Base::Base;
+
+    default_init_allocator() = default;
+
+    template<class U, class OtherBase>
+    default_init_allocator(
+            const default_init_allocator<U, OtherBase>& other ) noexcept :
+            Base( other ) {}
+
+    template<class U>
+    void
+    construct( U* ptr ) noexcept(
+            std::is_nothrow_default_constructible<U>::value ) {
+        ::new( static_cast<void*>( ptr ) ) U;
+    }
+
+    template<class U, class... Args>
+    void
+    construct( U* ptr, Args&&... args ) {
+        base_traits::construct( static_cast<Base&>( *this ),
+                                ptr,
+                                std::forward<Args>( args )... );
+    }
+};
+
+template<class T>
+using default_init_vector = std::vector<T, default_init_allocator<T>>;
+
+// alignment and padding of vecex::vector, the size of the widest simd vector
+static const size_t simd_alignment = 64;
+
+// allocates 64 byte aligned storage rounded up to a multiple of 64 bytes. the
+// padding behind the requested elements is zeroed
+template<class T>
+struct padded_allocator {
+    typedef T value_type;
+
+    padded_allocator() = default;
+
+    template<class U>
+    padded_allocator( const padded_allocator<U>& ) noexcept {}
+
+    T*
+    allocate( const size_t n ) {
+        const size_t bytes = n * sizeof( T );
+        const size_t padded_bytes = ( bytes + simd_alignment - 1 )
+                                    / simd_alignment * simd_alignment;
+        char* ptr = (char*)::operator new(
+                padded_bytes, std::align_val_t( simd_alignment ) );
+        std::memset( ptr + bytes, 0, padded_bytes - bytes );
+        return (T*)ptr;
+    }
+
+    void
+    deallocate( T* ptr, const size_t ) noexcept {
+        ::operator delete( ptr, std::align_val_t( simd_alignment ) );
+    }
+
+    template<class U>
+    bool
+    operator==( const padded_allocator<U>& ) const noexcept {
+        return true;
+    }
+    template<class U>
+    bool
+    operator!=( const padded_allocator<U>& ) const noexcept {
+        return false;
+    }
+};
+
+// std::vector with aligned and padded storage, compute on it with
+// vecex::policy<vecex::tail_mode::padded> needs no tail handling
+template<class T>
+using vector
+        = std::vector<T, default_init_allocator<T, padded_allocator<T>>>;
+
+// reductions for compute_reduce. combine works on simd vectors and on single
+// numbers, horizontal reduces a simd vector to a single number
+struct reduce_sum {
+    template<class T>
+    static inline T
+    identity() {
+        return T( 0 );
+    }
+    template<class V>
+    static inline V
+    combine( const V& a, const V& b ) {
+        return a + b;
+    }
+    template<class V>
+    static inline auto
+    horizontal( const V& v ) {
+        if constexpr ( std::is_arithmetic<V>::value ) {
+            return v;
+        } else {
+            return horizontal_add( v );
+        }
+    }
+};
+
+struct reduce_min {
+    template<class T>
+    static inline T
+    identity() {
+        return std::numeric_limits<T>::has_infinity
+                     ? std::numeric_limits<T>::infinity()
+                     : std::numeric_limits<T>::max();
+    }
+    template<class V>
+    static inline V
+    combine( const V& a, const V& b ) {
+        if constexpr ( std::is_arithmetic<V>::value ) {
+            return b < a ? b : a;
+        } else {
+            return min( a, b );
+        }
+    }
+    template<class V>
+    static inline auto
+    horizontal( const V& v ) {
+        if constexpr ( std::is_arithmetic<V>::value ) {
+            return v;
+        } else {
+            return horizontal_min( v );
+        }
+    }
+};
+
+struct reduce_max {
+    template<class T>
+    static inline T
+    identity() {
+        return std::numeric_limits<T>::has_infinity
+                     ? -std::numeric_limits<T>::infinity()
+                     : std::numeric_limits<T>::lowest();
+    }
+    template<class V>
+    static inline V
+    combine( const V& a, const V& b ) {
+        if constexpr ( std::is_arithmetic<V>::value ) {
+            return a < b ? b : a;
+        } else {
+            return max( a, b );
+        }
+    }
+    template<class V>
+    static inline auto
+    horizontal( const V& v ) {
+        if constexpr ( std::is_arithmetic<V>::value ) {
+            return v;
+        } else {
+            return horizontal_max( v );
+        }
+    }
+};
+
 //
 // for libusers completly irrelevant. just hide internal and use the
 // functionality below internal
@@ -337,16 +808,175 @@ struct simd_vec_sizes<unsigned char> {
     static const size_t max = 64;
 };
 
+// precomputed integer divisor of the vectorclass (multiply and shift). the
+// other types divide by the number itself
+template<class T>
+struct divisor_type {
+    typedef T type;
+};
+template<>
+struct divisor_type<int> {
+    typedef Divisor_i type;
+};
+template<>
+struct divisor_type<unsigned int> {
+    typedef Divisor_ui type;
+};
+template<>
+struct divisor_type<short> {
+    typedef Divisor_s type;
+};
+template<>
+struct divisor_type<unsigned short> {
+    typedef Divisor_us type;
+};
+template<>
+struct divisor_type<char> {
+    typedef Divisor_s type;
+};
+template<>
+struct divisor_type<unsigned char> {
+    typedef Divisor_us type;
+};
+
+// integers without a vectorclass division (64 bit) divide lane by lane
+template<class T>
+struct has_simd_division {
+    static const bool value
+            = std::is_floating_point<T>::value
+              || !std::is_same<typename divisor_type<T>::type, T>::value;
+};
+
 };    // namespace translation_types
 
+// the vectorclass math functions for the simd Value. the methods of Value
+// have the same names and would hide them inside of the class
+namespace math {
+
+template<class V>
+inline V
+sqrt_of( const V& v ) {
+    return sqrt( v );
+}
+template<class V>
+inline V
+exp_of( const V& v ) {
+    return exp( v );
+}
+template<class V>
+inline V
+log_of( const V& v ) {
+    return log( v );
+}
+template<class V>
+inline V
+sin_of( const V& v ) {
+    return sin( v );
+}
+template<class V>
+inline V
+cos_of( const V& v ) {
+    return cos( v );
+}
+template<class V>
+inline V
+tan_of( const V& v ) {
+    return tan( v );
+}
+template<class V>
+inline V
+tanh_of( const V& v ) {
+    return tanh( v );
+}
+template<class V>
+inline V
+pow_of( const V& v, const V& exponent ) {
+    return pow( v, exponent );
+}
+
+template<class M, class V>
+inline V
+select_of( const M& mask, const V& a, const V& b ) {
+    return select( mask, a, b );
+}
+
+// a * b + c, a * b - c and -( a * b ) + c. vectorclass has them for float
+// and double only, integers take the separate operations
+template<class CalcType, class V>
+inline V
+mul_add_of( const V& a, const V& b, const V& c ) {
+    if constexpr ( std::is_floating_point<CalcType>::value ) {
+        return mul_add( a, b, c );
+    } else {
+        return a * b + c;
+    }
+}
+template<class CalcType, class V>
+inline V
+mul_sub_of( const V& a, const V& b, const V& c ) {
+    if constexpr ( std::is_floating_point<CalcType>::value ) {
+        return mul_sub( a, b, c );
+    } else {
+        return a * b - c;
+    }
+}
+template<class CalcType, class V>
+inline V
+nmul_add_of( const V& a, const V& b, const V& c ) {
+    if constexpr ( std::is_floating_point<CalcType>::value ) {
+        return nmul_add( a, b, c );
+    } else {
+        return c - a * b;
+    }
+}
+
+};    // namespace math
+
 namespace compute {
 
+// lane indices that move the set lanes of an 8 lane mask to the front, for
+// the AVX2 compaction of emit
+struct compress_indices {
+    alignas( 32 ) int32_t lanes[256][8];
+
+    constexpr compress_indices() : lanes {} {
+        for ( int bits = 0; bits < 256; bits++ ) {
+            int count = 0;
+            for ( int i = 0; i < 8; i++ ) {
+                if ( ( bits >> i ) & 1 ) {
+                    lanes[bits][count++] = i;
+                }
+            }
+        }
+    }
+};
+
+inline constexpr compress_indices compress_table {};
+
+template<class _Value>
+struct Product;
+
+template<typename CalcType, size_t unroll_size, bool simd>
+struct Mask;
+
+// valid lanes of the tail context that runs on this thread (run_tail). the
+// integer division divides the unused lanes of a masked or padded tail by 1
+inline size_t&
+tail_lanes() {
+    static thread_local size_t count = std::numeric_limits<size_t>::max();
+    return count;
+}
+
 template<typename CalcType, size_t unroll_size, bool simd>
 struct Value {
     typedef Value<CalcType, unroll_size, simd> _Value;
+    typedef Mask<CalcType, unroll_size, simd>  _Mask;
+    typedef CalcType                           calc_type;
     typedef translation_types::simd_vec_type_t<CalcType, unroll_size>
                _SIMD_Type;
-    _SIMD_Type value;
+    // size of the simd vector, picks the masked store instructions
+    static const size_t BYTES = sizeof( _SIMD_Type );
+    _SIMD_Type          value;
 
     static inline _Value
     from_number( const CalcType& number ) {
@@ -364,131 +994,1097 @@ struct Value {
         this->value.store( ptr );
     }
 
+    // ptr has to be aligned to the size of the simd vector
+    static inline _Value
+    load_a( const CalcType* ptr ) {
+        _Value result;
+        result.value.load_a( ptr );
+        return result;
+    }
+    inline void
+    store_a( CalcType* ptr ) const {
+        this->value.store_a( ptr );
+    }
+
+    // alignment store_nt needs: the width of the native registers. vectors
+    // wider than the instruction set are emulated and stored in halves
+    static const size_t NATIVE_BYTES
+            = ( sizeof( CalcType ) <= 2 ? INSTRSET >= 10 : INSTRSET >= 9 ) ? 64
+              : ( std::is_floating_point<CalcType>::value ? INSTRSET >= 7
+                                                           : INSTRSET >= 8 )
+                      ? 32
+                      : 16;
+    static const size_t STREAM_ALIGNMENT
+            = BYTES < NATIVE_BYTES ? BYTES : NATIVE_BYTES;
+
+    // non-temporal store if ptr is aligned for store_nt, a normal one
+    // otherwise. returns if it streamed
+    inline bool
+    store_stream( CalcType* ptr ) const {
+        if ( (size_t)ptr % STREAM_ALIGNMENT == 0 ) {
+            this->value.store_nt( ptr );
+            return true;
+        }
+        this->value.store( ptr );
+        return false;
+    }
+
+    // only the first count elements are touched, the rest is zero
+    static inline _Value
+    load_partial( const CalcType* ptr, const size_t count ) {
+        _Value result;
+        result.value.load_partial( (int)count, ptr );
+        return result;
+    }
+    inline void
+    store_partial( CalcType* ptr, const size_t count ) const {
+        this->value.store_partial( (int)count, ptr );
+    }
+
+    // stores only the lanes set in mask. AVX-512 has masked stores for all
+    // types, AVX2 for 32 and 64 bit lanes of 256 bit vectors. everything
+    // else blends with the old content (skipped if no lane or every lane
+    // is set), which reads the memory and writes the unset lanes back
+    inline void
+    store_if( CalcType* ptr, const _Mask& mask ) const {
+#if INSTRSET >= 10
+        if constexpr ( BYTES == 16 || BYTES == 32 || BYTES == 64 ) {
+            store_masked( ptr, to_bits( mask.value ) );
+            return;
+        }
+#elif INSTRSET >= 8
+        if constexpr ( BYTES == 32 && sizeof( CalcType ) >= 4 ) {
+            store_masked( ptr, mask.value );
+            return;
+        }
+#endif
+        if ( !mask.any() ) {
+            return;
+        }
+        if ( mask.all() ) {
+            store( ptr );
+            return;
+        }
+        _Value old = load( ptr );
+        _Value { math::select_of( mask.value, this->value, old.value ) }
+                .store( ptr );
+    }
+
+    // store_if of a masked tail, only the first count lanes
+    inline void
+    store_if_partial( CalcType*    ptr,
+                      const _Mask& mask,
+                      const size_t count ) const {
+        CalcType       lanes[unroll_size];
+        const uint64_t bits = to_bits( mask.value );
+        this->value.store( lanes );
+        for ( size_t i = 0; i < count; i++ ) {
+            if ( ( bits >> i ) & 1 ) {
+                ptr[i] = lanes[i];
+            }
+        }
+    }
+
+    // writes the lanes set in mask contiguously to ptr and returns how many.
+    // AVX-512 compress stores only those, the AVX2 permute and the lane loop
+    // write the whole vector (the lanes behind the count are garbage)
+    inline size_t
+    compress_store( CalcType* ptr, const _Mask& mask ) const {
+#if INSTRSET >= 10
+        if constexpr ( sizeof( CalcType ) >= 4
+                       && ( BYTES == 16 || BYTES == 32 || BYTES == 64 ) ) {
+            compress_masked( ptr, to_bits( mask.value ) );
+            return horizontal_count( mask.value );
+        }
+#ifdef __AVX512VBMI2__
+        if constexpr ( BYTES == 16 || BYTES == 32 || BYTES == 64 ) {
+            compress_masked( ptr, to_bits( mask.value ) );
+            return horizontal_count( mask.value );
+        }
+#endif
+#elif INSTRSET >= 8
+        if constexpr ( unroll_size == 8 && sizeof( CalcType ) == 4 ) {
+            Vec8i indices;
+            indices.load_a( compress_table.lanes[to_bits( mask.value )] );
+            _SIMD_Type( lookup8( indices, this->value ) ).store( ptr );
+            return horizontal_count( mask.value );
+        }
+#endif
+        return compress_store_partial( ptr, mask, unroll_size );
+    }
+
+    // compress_store of a masked tail, only the first count lanes. lane i
+    // is written to the current end, which only moves on if it is set
+    inline size_t
+    compress_store_partial( CalcType*    ptr,
+                            const _Mask& mask,
+                            const size_t count ) const {
+        CalcType       lanes[unroll_size];
+        const uint64_t bits = to_bits( mask.value );
+        this->value.store( lanes );
+        size_t emitted = 0;
+        for ( size_t i = 0; i < count; i++ ) {
+            ptr[emitted] = lanes[i];
+            emitted += ( bits >> i ) & 1;
+        }
+        return emitted;
+    }
+
+#if INSTRSET >= 10
+    // AVX-512 compress store, 8 and 16 bit lanes need VBMI2
+    inline void
+    compress_masked( CalcType* ptr, const uint64_t bits ) const {
+        if constexpr ( std::is_same<CalcType, float>::value ) {
+            if constexpr ( BYTES == 16 ) {
+                _mm_mask_compressstoreu_ps( ptr, bits, this->value );
+            } else if constexpr ( BYTES == 32 ) {
+                _mm256_mask_compressstoreu_ps( ptr, bits, this->value );
+            } else {
+                _mm512_mask_compressstoreu_ps( ptr, bits, this->value );
+            }
+        } else if constexpr ( std::is_same<CalcType, double>::value ) {
+            if constexpr ( BYTES == 16 ) {
+                _mm_mask_compressstoreu_pd( ptr, bits, this->value );
+            } else if constexpr ( BYTES == 32 ) {
+                _mm256_mask_compressstoreu_pd( ptr, bits, this->value );
+            } else {
+                _mm512_mask_compressstoreu_pd( ptr, bits, this->value );
+            }
+        } else if constexpr ( sizeof( CalcType ) == 4 ) {
+            if constexpr ( BYTES == 16 ) {
+                _mm_mask_compressstoreu_epi32( ptr, bits, this->value );
+            } else if constexpr ( BYTES == 32 ) {
+                _mm256_mask_compressstoreu_epi32( ptr, bits, this->value );
+            } else {
+                _mm512_mask_compressstoreu_epi32( ptr, bits, this->value );
+            }
+        } else if constexpr ( sizeof( CalcType ) == 8 ) {
+            if constexpr ( BYTES == 16 ) {
+                _mm_mask_compressstoreu_epi64( ptr, bits, this->value );
+            } else if constexpr ( BYTES == 32 ) {
+                _mm256_mask_compressstoreu_epi64( ptr, bits, this->value );
+            } else {
+                _mm512_mask_compressstoreu_epi64( ptr, bits, this->value );
+            }
+        }
+#ifdef __AVX512VBMI2__
+        else if constexpr ( sizeof( CalcType ) == 1 ) {
+            if constexpr ( BYTES == 16 ) {
+                _mm_mask_compressstoreu_epi8( ptr, bits, this->value );
+            } else if constexpr ( BYTES == 32 ) {
+                _mm256_mask_compressstoreu_epi8( ptr, bits, this->value );
+            } else {
+                _mm512_mask_compressstoreu_epi8( ptr, bits, this->value );
+            }
+        } else {
+            if constexpr ( BYTES == 16 ) {
+                _mm_mask_compressstoreu_epi16( ptr, bits, this->value );
+            } else if constexpr ( BYTES == 32 ) {
+                _mm256_mask_compressstoreu_epi16( ptr, bits, this->value );
+            } else {
+                _mm512_mask_compressstoreu_epi16( ptr, bits, this->value );
+            }
+        }
+#endif
+    }
+
+    // AVX-512 (with BW and VL), bits has one bit per lane
+    inline void
+    store_masked( CalcType* ptr, const uint64_t bits ) const {
+        if constexpr ( std::is_same<CalcType, float>::value ) {
+            if constexpr ( BYTES == 16 ) {
+                _mm_mask_storeu_ps( ptr, bits, this->value );
+            } else if constexpr ( BYTES == 32 ) {
+                _mm256_mask_storeu_ps( ptr, bits, this->value );
+            } else {
+                _mm512_mask_storeu_ps( ptr, bits, this->value );
+            }
+        } else if constexpr ( std::is_same<CalcType, double>::value ) {
+            if constexpr ( BYTES == 16 ) {
+                _mm_mask_storeu_pd( ptr, bits, this->value );
+            } else if constexpr ( BYTES == 32 ) {
+                _mm256_mask_storeu_pd( ptr, bits, this->value );
+            } else {
+                _mm512_mask_storeu_pd( ptr, bits, this->value );
+            }
+        } else if constexpr ( sizeof( CalcType ) == 1 ) {
+            if constexpr ( BYTES == 16 ) {
+                _mm_mask_storeu_epi8( ptr, bits, this->value );
+            } else if constexpr ( BYTES == 32 ) {
+                _mm256_mask_storeu_epi8( ptr, bits, this->value );
+            } else {
+                _mm512_mask_storeu_epi8( ptr, bits, this->value );
+            }
+        } else if constexpr ( sizeof( CalcType ) == 2 ) {
+            if constexpr ( BYTES == 16 ) {
+                _mm_mask_storeu_epi16( ptr, bits, this->value );
+            } else if constexpr ( BYTES == 32 ) {
+                _mm256_mask_storeu_epi16( ptr, bits, this->value );
+            } else {
+                _mm512_mask_storeu_epi16( ptr, bits, this->value );
+            }
+        } else if constexpr ( sizeof( CalcType ) == 4 ) {
+            if constexpr ( BYTES == 16 ) {
+                _mm_mask_storeu_epi32( ptr, bits, this->value );
+            } else if constexpr ( BYTES == 32 ) {
+                _mm256_mask_storeu_epi32( ptr, bits, this->value );
+            } else {
+                _mm512_mask_storeu_epi32( ptr, bits, this->value );
+            }
+        } else {
+            if constexpr ( BYTES == 16 ) {
+                _mm_mask_storeu_epi64( ptr, bits, this->value );
+            } else if constexpr ( BYTES == 32 ) {
+                _mm256_mask_storeu_epi64( ptr, bits, this->value );
+            } else {
+                _mm512_mask_storeu_epi64( ptr, bits, this->value );
+            }
+        }
+    }
+#elif INSTRSET >= 8
+    // AVX2 maskstore, the mask is a full vector with all bits of a lane set
+    template<class _SIMD_Mask>
+    inline void
+    store_masked( CalcType* ptr, const _SIMD_Mask& mask ) const {
+        if constexpr ( std::is_same<CalcType, float>::value ) {
+            _mm256_maskstore_ps(
+                    ptr, _mm256_castps_si256( mask ), this->value );
+        } else if constexpr ( std::is_same<CalcType, double>::value ) {
+            _mm256_maskstore_pd(
+                    ptr, _mm256_castpd_si256( mask ), this->value );
+        } else if constexpr ( sizeof( CalcType ) == 4 ) {
+            _mm256_maskstore_epi32( (int*)ptr, mask, this->value );
+        } else {
+            _mm256_maskstore_epi64( (long long*)ptr, mask, this->value );
+        }
+    }
+#endif
+
     // with possible simd
     inline _Value
-    operator+( const _Value& rh ) {
-        return _Value { value = this->value + rh.value };
+    operator+( const _Value& rh ) const {
+        return _Value { this->value + rh.value };
+    }
+    inline _Value
+    operator-( const _Value& rh ) const {
+        return _Value { this->value - rh.value };
     }
     inline _Value
-    operator-( const _Value& rh ) {
-        return _Value { value = this->value - rh.value };
+    operator+( const Product<_Value>& rh ) const {
+        return rh.a.mul_add( rh.b, *this );
     }
     inline _Value
-    operator*( const _Value& rh ) {
-        return _Value { value = this->value * rh.value };
+    operator-( const Product<_Value>& rh ) const {
+        return rh.a.nmul_add( rh.b, *this );
+    }
+    inline Product<_Value>
+    operator*( const _Value& rh ) const {
+        return Product<_Value>( *this, rh );
     }
     inline _Value
-    operator/( const _Value& rh ) {
-        return _Value { value = this->value / rh.value };
+    operator/( const _Value& rh ) const {
+        if constexpr ( std::is_floating_point<CalcType>::value ) {
+            return _Value { this->value / rh.value };
+        } else {
+            return divide_lanes( rh );
+        }
     }
 
     // with skalar value
     inline _Value
-    operator+( const CalcType& rh ) {
-        return _Value { value = this->value + rh };
+    operator+( const CalcType& rh ) const {
+        return _Value { this->value + rh };
     }
     inline _Value
-    operator-( const CalcType& rh ) {
-        return _Value { value = this->value - rh };
+    operator-( const CalcType& rh ) const {
+        return _Value { this->value - rh };
+    }
+    inline Product<_Value>
+    operator*( const CalcType& rh ) const {
+        return Product<_Value>( *this, from_number( rh ) );
     }
     inline _Value
-    operator*( const CalcType& rh ) {
-        return _Value { value = this->value * rh };
+    operator/( const CalcType& rh ) const {
+        static_assert( std::is_floating_point<CalcType>::value,
+                       "integer value / number: capture a vecex::divisor<T> "
+                       "in the lambda, ctx.load( 0 ) / d" );
+        return _Value { this->value / rh };
     }
     inline _Value
-    operator/( const CalcType& rh ) {
-        return _Value { value = this->value / rh };
+    operator/( const divisor<CalcType>& rh ) const {
+        if constexpr ( translation_types::has_simd_division<
+                               CalcType>::value ) {
+            return _Value { this->value / rh.simd };
+        } else {
+            return divide_lanes( from_number( rh.number ) );
+        }
     }
-};
 
-template<typename CalcType, size_t unroll_size>
-struct Value<CalcType, unroll_size, false> {
-    typedef Value<CalcType, unroll_size, false> _Value;
-    CalcType                                    value;
+    // integer division of every lane on its own. x / 0 is undefined like
+    // for a single integer, only the unused lanes of a tail (loaded as 0)
+    // divide by 1
+    inline _Value
+    divide_lanes( const _Value& rh ) const {
+        CalcType     lanes[unroll_size];
+        CalcType     divisors[unroll_size];
+        const size_t count = tail_lanes();
+        this->value.store( lanes );
+        rh.value.store( divisors );
+        for ( size_t i = 0; i < unroll_size; i++ ) {
+            lanes[i] /= i < count ? divisors[i] : CalcType( 1 );
+        }
+        return load( lanes );
+    }
 
-    static inline _Value
-    from_number( const CalcType& number ) {
-        return { number };
+    // comparisons, lane by lane
+    inline Mask<CalcType, unroll_size, simd>
+    operator==( const _Value& rh ) const {
+        return { this->value == rh.value };
+    }
+    inline Mask<CalcType, unroll_size, simd>
+    operator!=( const _Value& rh ) const {
+        return { this->value != rh.value };
+    }
+    inline Mask<CalcType, unroll_size, simd>
+    operator<( const _Value& rh ) const {
+        return { this->value < rh.value };
+    }
+    inline Mask<CalcType, unroll_size, simd>
+    operator<=( const _Value& rh ) const {
+        return { this->value <= rh.value };
+    }
+    inline Mask<CalcType, unroll_size, simd>
+    operator>( const _Value& rh ) const {
+        return { this->value > rh.value };
+    }
+    inline Mask<CalcType, unroll_size, simd>
+    operator>=( const _Value& rh ) const {
+        return { this->value >= rh.value };
     }
 
-    static inline _Value
-    load( const CalcType* ptr ) {
-        _Value result;
-        result.value = *( ptr );
-        return result;
+    inline Mask<CalcType, unroll_size, simd>
+    operator==( const CalcType& rh ) const {
+        return *this == from_number( rh );
     }
-    inline void
-    store( CalcType* ptr ) const {
-        *( ptr ) = this->value;
+    inline Mask<CalcType, unroll_size, simd>
+    operator!=( const CalcType& rh ) const {
+        return *this != from_number( rh );
+    }
+    inline Mask<CalcType, unroll_size, simd>
+    operator<( const CalcType& rh ) const {
+        return *this < from_number( rh );
+    }
+    inline Mask<CalcType, unroll_size, simd>
+    operator<=( const CalcType& rh ) const {
+        return *this <= from_number( rh );
+    }
+    inline Mask<CalcType, unroll_size, simd>
+    operator>( const CalcType& rh ) const {
+        return *this > from_number( rh );
+    }
+    inline Mask<CalcType, unroll_size, simd>
+    operator>=( const CalcType& rh ) const {
+        return *this >= from_number( rh );
     }
 
-    // with possible simd
+    // math, float and double only
     inline _Value
-    operator+( const _Value& rh ) {
-        return _Value { value = this->value + rh.value };
+    sqrt() const {
+        return _Value { math::sqrt_of( this->value ) };
     }
     inline _Value
-    operator-( const _Value& rh ) {
-        return _Value { value = this->value - rh.value };
+    exp() const {
+        return _Value { math::exp_of( this->value ) };
     }
     inline _Value
-    operator*( const _Value& rh ) {
-        return _Value { value = this->value * rh.value };
+    log() const {
+        return _Value { math::log_of( this->value ) };
     }
     inline _Value
-    operator/( const _Value& rh ) {
-        return _Value { value = this->value / rh.value };
+    sin() const {
+        return _Value { math::sin_of( this->value ) };
     }
-
-    // with skalar
     inline _Value
-    operator+( const CalcType& rh ) {
-        return _Value { value = this->value + rh };
+    cos() const {
+        return _Value { math::cos_of( this->value ) };
     }
     inline _Value
-    operator-( const CalcType& rh ) {
-        return _Value { value = this->value - rh };
+    tan() const {
+        return _Value { math::tan_of( this->value ) };
     }
     inline _Value
-    operator*( const CalcType& rh ) {
-        return _Value { value = this->value * rh };
+    tanh() const {
+        return _Value { math::tanh_of( this->value ) };
     }
     inline _Value
-    operator/( const CalcType& rh ) {
-        return _Value { value = this->value / rh };
+    pow( const _Value& exponent ) const {
+        return _Value { math::pow_of( this->value, exponent.value ) };
+    }
+    inline _Value
+    pow( const CalcType& exponent ) const {
+        return _Value { math::pow_of( this->value, _SIMD_Type( exponent ) ) };
     }
-};
 
-template<class CalcType, size_t extern_size>
-struct State {
-    const std::array<CalcType*, extern_size> data_sets;
-    size_t                                   offset;
-    const size_t                             element_count;
+    // this * b + c, with FMA in a single instruction and rounding
+    inline _Value
+    mul_add( const _Value& b, const _Value& c ) const {
+        return _Value { math::mul_add_of<CalcType>(
+                this->value, b.value, c.value ) };
+    }
+    // this * b - c
+    inline _Value
+    mul_sub( const _Value& b, const _Value& c ) const {
+        return _Value { math::mul_sub_of<CalcType>(
+                this->value, b.value, c.value ) };
+    }
+    // -( this * b ) + c
+    inline _Value
+    nmul_add( const _Value& b, const _Value& c ) const {
+        return _Value { math::nmul_add_of<CalcType>(
+                this->value, b.value, c.value ) };
+    }
 };
 
-template<class CalcType, size_t extern_size, size_t unroll_size>
-struct Context {
-    typedef Value<
-            CalcType,
-            unroll_size,
-            translation_types::simd_vec_size_is_in_lower_bound<
-                    CalcType,
+// result of a comparison, one bool per lane. combine with & | ^ ~ and use it
+// in vecex::select / if_add / if_sub / if_mul
+template<typename CalcType, size_t unroll_size, bool simd>
+struct Mask {
+    typedef Mask<CalcType, unroll_size, simd> _Mask;
+    typedef translation_types::simd_vec_type_t<CalcType, unroll_size>
+               _SIMD_Value_Type;
+    typedef decltype( std::declval<_SIMD_Value_Type>()
+                      < std::declval<_SIMD_Value_Type>() ) _SIMD_Type;
+    _SIMD_Type value;
+
+    inline _Mask
+    operator&( const _Mask& rh ) const {
+        return _Mask { this->value & rh.value };
+    }
+    inline _Mask
+    operator|( const _Mask& rh ) const {
+        return _Mask { this->value | rh.value };
+    }
+    inline _Mask
+    operator^( const _Mask& rh ) const {
+        return _Mask { this->value ^ rh.value };
+    }
+    inline _Mask
+    operator~() const {
+        return _Mask { ~this->value };
+    }
+
+    // true if any / every lane is set
+    inline bool
+    any() const {
+        return horizontal_or( this->value );
+    }
+    inline bool
+    all() const {
+        return horizontal_and( this->value );
+    }
+};
+
+template<typename CalcType, size_t unroll_size>
+struct Mask<CalcType, unroll_size, false> {
+    typedef Mask<CalcType, unroll_size, false> _Mask;
+    bool                                       value;
+
+    inline _Mask
+    operator&( const _Mask& rh ) const {
+        return _Mask { this->value && rh.value };
+    }
+    inline _Mask
+    operator|( const _Mask& rh ) const {
+        return _Mask { this->value || rh.value };
+    }
+    inline _Mask
+    operator^( const _Mask& rh ) const {
+        return _Mask { this->value != rh.value };
+    }
+    inline _Mask
+    operator~() const {
+        return _Mask { !this->value };
+    }
+
+    inline bool
+    any() const {
+        return this->value;
+    }
+    inline bool
+    all() const {
+        return this->value;
+    }
+};
+
+// result of a simd multiplication. it is a normal Value, but keeps the
+// factors, so an addition or subtraction right after it becomes a single
+// mul_add / mul_sub / nmul_add. the unused product is optimized away
+template<class _Value>
+struct Product : _Value {
+    typedef typename _Value::calc_type CalcType;
+    _Value a;
+    _Value b;
+
+    Product( const _Value& a, const _Value& b ) :
+            _Value { a.value * b.value }, a( a ), b( b ) {}
+
+    // a product variable that gets a new value: value * 1 still fuses
+    inline Product&
+    operator=( const _Value& other ) {
+        this->value = other.value;
+        this->a = other;
+        this->b = _Value::from_number( 1 );
+        return *this;
+    }
+
+    using _Value::operator+;
+    using _Value::operator-;
+
+    inline _Value
+    operator+( const _Value& rh ) const {
+        return this->a.mul_add( this->b, rh );
+    }
+    inline _Value
+    operator-( const _Value& rh ) const {
+        return this->a.mul_sub( this->b, rh );
+    }
+    inline _Value
+    operator+( const CalcType& rh ) const {
+        return this->a.mul_add( this->b, _Value::from_number( rh ) );
+    }
+    inline _Value
+    operator-( const CalcType& rh ) const {
+        return this->a.mul_sub( this->b, _Value::from_number( rh ) );
+    }
+    inline _Value
+    operator+( const Product& rh ) const {
+        return this->a.mul_add( this->b, rh );
+    }
+    inline _Value
+    operator-( const Product& rh ) const {
+        return this->a.mul_sub( this->b, rh );
+    }
+};
+
+template<typename CalcType, size_t unroll_size>
+struct Value<CalcType, unroll_size, false> {
+    typedef Value<CalcType, unroll_size, false> _Value;
+    typedef Mask<CalcType, unroll_size, false>  _Mask;
+    typedef CalcType                            calc_type;
+    CalcType                                    value;
+
+    static inline _Value
+    from_number( const CalcType& number ) {
+        return { number };
+    }
+
+    static inline _Value
+    load( const CalcType* ptr ) {
+        _Value result;
+        result.value = *( ptr );
+        return result;
+    }
+    inline void
+    store( CalcType* ptr ) const {
+        *( ptr ) = this->value;
+    }
+
+    static inline _Value
+    load_a( const CalcType* ptr ) {
+        return load( ptr );
+    }
+
+    inline void
+    store_if( CalcType* ptr, const _Mask& mask ) const {
+        if ( mask.value ) {
+            store( ptr );
+        }
+    }
+    inline size_t
+    compress_store( CalcType* ptr, const _Mask& mask ) const {
+        store( ptr );
+        return mask.value ? 1 : 0;
+    }
+    inline void
+    store_a( CalcType* ptr ) const {
+        store( ptr );
+    }
+
+    inline bool
+    store_stream( CalcType* ptr ) const {
+        store( ptr );
+        return false;
+    }
+
+    // with possible simd
+    inline _Value
+    operator+( const _Value& rh ) const {
+        return _Value { (CalcType)( this->value + rh.value ) };
+    }
+    inline _Value
+    operator-( const _Value& rh ) const {
+        return _Value { (CalcType)( this->value - rh.value ) };
+    }
+    inline _Value
+    operator*( const _Value& rh ) const {
+        return _Value { (CalcType)( this->value * rh.value ) };
+    }
+    inline _Value
+    operator/( const _Value& rh ) const {
+        return _Value { (CalcType)( this->value / rh.value ) };
+    }
+
+    // with skalar
+    inline _Value
+    operator+( const CalcType& rh ) const {
+        return _Value { (CalcType)( this->value + rh ) };
+    }
+    inline _Value
+    operator-( const CalcType& rh ) const {
+        return _Value { (CalcType)( this->value - rh ) };
+    }
+    inline _Value
+    operator*( const CalcType& rh ) const {
+        return _Value { (CalcType)( this->value * rh ) };
+    }
+    inline _Value
+    operator/( const CalcType& rh ) const {
+        return _Value { (CalcType)( this->value / rh ) };
+    }
+    inline _Value
+    operator/( const divisor<CalcType>& rh ) const {
+        return _Value { (CalcType)( this->value / rh.number ) };
+    }
+
+    // comparisons, lane by lane
+    inline Mask<CalcType, unroll_size, false>
+    operator==( const _Value& rh ) const {
+        return { this->value == rh.value };
+    }
+    inline Mask<CalcType, unroll_size, false>
+    operator!=( const _Value& rh ) const {
+        return { this->value != rh.value };
+    }
+    inline Mask<CalcType, unroll_size, false>
+    operator<( const _Value& rh ) const {
+        return { this->value < rh.value };
+    }
+    inline Mask<CalcType, unroll_size, false>
+    operator<=( const _Value& rh ) const {
+        return { this->value <= rh.value };
+    }
+    inline Mask<CalcType, unroll_size, false>
+    operator>( const _Value& rh ) const {
+        return { this->value > rh.value };
+    }
+    inline Mask<CalcType, unroll_size, false>
+    operator>=( const _Value& rh ) const {
+        return { this->value >= rh.value };
+    }
+
+    inline Mask<CalcType, unroll_size, false>
+    operator==( const CalcType& rh ) const {
+        return *this == from_number( rh );
+    }
+    inline Mask<CalcType, unroll_size, false>
+    operator!=( const CalcType& rh ) const {
+        return *this != from_number( rh );
+    }
+    inline Mask<CalcType, unroll_size, false>
+    operator<( const CalcType& rh ) const {
+        return *this < from_number( rh );
+    }
+    inline Mask<CalcType, unroll_size, false>
+    operator<=( const CalcType& rh ) const {
+        return *this <= from_number( rh );
+    }
+    inline Mask<CalcType, unroll_size, false>
+    operator>( const CalcType& rh ) const {
+        return *this > from_number( rh );
+    }
+    inline Mask<CalcType, unroll_size, false>
+    operator>=( const CalcType& rh ) const {
+        return *this >= from_number( rh );
+    }
+
+    // math
+    inline _Value
+    sqrt() const {
+        return _Value { (CalcType)std::sqrt( this->value ) };
+    }
+    inline _Value
+    exp() const {
+        return _Value { (CalcType)std::exp( this->value ) };
+    }
+    inline _Value
+    log() const {
+        return _Value { (CalcType)std::log( this->value ) };
+    }
+    inline _Value
+    sin() const {
+        return _Value { (CalcType)std::sin( this->value ) };
+    }
+    inline _Value
+    cos() const {
+        return _Value { (CalcType)std::cos( this->value ) };
+    }
+    inline _Value
+    tan() const {
+        return _Value { (CalcType)std::tan( this->value ) };
+    }
+    inline _Value
+    tanh() const {
+        return _Value { (CalcType)std::tanh( this->value ) };
+    }
+    inline _Value
+    pow( const _Value& exponent ) const {
+        return _Value { (CalcType)std::pow( this->value, exponent.value ) };
+    }
+    inline _Value
+    pow( const CalcType& exponent ) const {
+        return _Value { (CalcType)std::pow( this->value, exponent ) };
+    }
+
+    inline _Value
+    mul_add( const _Value& b, const _Value& c ) const {
+        return _Value { (CalcType)( this->value * b.value + c.value ) };
+    }
+    inline _Value
+    mul_sub( const _Value& b, const _Value& c ) const {
+        return _Value { (CalcType)( this->value * b.value - c.value ) };
+    }
+    inline _Value
+    nmul_add( const _Value& b, const _Value& c ) const {
+        return _Value { (CalcType)( c.value - this->value * b.value ) };
+    }
+};
+
+// table[index] for every lane. 32 bit indices into a 32 bit table and 64 bit
+// ones into a 64 bit table use the vectorclass lookup (a gather with AVX2
+// and AVX-512), the other combinations and partial vectors go lane by lane.
+// only the first count lanes are valid, the others are 0. debug builds check
+// the indices against table_size if it isn't 0
+template<class T, class I, size_t unroll_size, bool simd>
+inline Value<T, unroll_size, simd>
+gather_lanes( const T*                           table,
+              const Value<I, unroll_size, simd>& index,
+              const size_t                       count,
+              const size_t                       table_size ) {
+    static const bool TABLE_SIMD
+            = translation_types::simd_vec_size_is_in_lower_bound<
+                    T,
+                    unroll_size>::value;
+    static_assert( std::is_integral<I>::value,
+                   "gather needs integer indices" );
+    static_assert( !simd || TABLE_SIMD,
+                   "the table type has no simd vector with the lanes of the "
+                   "index" );
+    typedef Value<T, unroll_size, simd> _Result;
+
+    if constexpr ( !simd ) {
+        assert( table_size == 0 || (size_t)index.value < table_size );
+        return _Result { table[index.value] };
+    } else {
+        I lanes[unroll_size];
+        index.value.store( lanes );
+#ifndef NDEBUG
+        for ( size_t i = 0; i < count; i++ ) {
+            assert( table_size == 0 || (size_t)lanes[i] < table_size );
+        }
+#endif
+        if constexpr ( sizeof( T ) == sizeof( I )
+                       && ( sizeof( T ) == 4 || sizeof( T ) == 8 ) ) {
+            if ( count == unroll_size ) {
+                typedef typename _Result::_SIMD_Type _SIMD_Type;
+                return _Result { _SIMD_Type(
+                        lookup<std::numeric_limits<int>::max()>( index.value,
+                                                                 table ) ) };
+            }
+        }
+        T values[unroll_size] = {};
+        for ( size_t i = 0; i < count; i++ ) {
+            values[i] = table[lanes[i]];
+        }
+        return _Result::load( values );
+    }
+}
+
+// base[index] = value for every lane, lanes with the same index keep the
+// value of the highest lane (last writer wins). same widths as gather_lanes
+// use the vectorclass scatter (AVX-512 scatter, a store per lane before)
+template<class T, class I, size_t unroll_size, bool simd>
+inline void
+scatter_lanes( T*                                 base,
+               const Value<I, unroll_size, simd>& index,
+               const Value<T, unroll_size, simd>& value,
+               const size_t                       count,
+               const size_t                       table_size ) {
+    static_assert( std::is_integral<I>::value,
+                   "scatter needs integer indices" );
+
+    if constexpr ( !simd ) {
+        assert( table_size == 0 || (size_t)index.value < table_size );
+        base[index.value] = value.value;
+    } else {
+        I lanes[unroll_size];
+        index.value.store( lanes );
+#ifndef NDEBUG
+        for ( size_t i = 0; i < count; i++ ) {
+            assert( table_size == 0 || (size_t)lanes[i] < table_size );
+        }
+#endif
+        if constexpr ( sizeof( T ) == sizeof( I )
+                       && ( sizeof( T ) == 4 || sizeof( T ) == 8 ) ) {
+            if ( count == unroll_size ) {
+                scatter( index.value,
+                         std::numeric_limits<uint32_t>::max(),
+                         value.value,
+                         base );
+                return;
+            }
+        }
+        T values[unroll_size];
+        value.value.store( values );
+        for ( size_t i = 0; i < count; i++ ) {
+            base[lanes[i]] = values[i];
+        }
+    }
+}
+
+// the reductions of a compute_reduce call. the accumulators of every unroll
+// level stay simd vectors and are reduced horizontally into the results of
+// the State once the level is done
+template<class... Ops>
+struct Reductions {
+    static const size_t size = sizeof...( Ops );
+    // false for the chunks of run_range, see ranged
+    static const bool whole_range = true;
+
+    template<class CalcType>
+    static inline std::array<CalcType, size>
+    identities() {
+        return { Ops::template identity<CalcType>()... };
+    }
+
+    template<class CalcType, class _Value>
+    static inline void
+    init( std::array<_Value, size>& acc ) {
+        const std::array<CalcType, size> numbers = identities<CalcType>();
+        for ( size_t i = 0; i < size; i++ ) {
+            acc[i] = _Value::from_number( numbers[i] );
+        }
+    }
+
+    template<class _Value>
+    static inline void
+    accumulate( _Value* acc, const _Value& value, const size_t slot ) {
+        accumulate( acc, value, slot, std::index_sequence_for<Ops...> {} );
+    }
+
+    // only the first count lanes of value are valid, the others are replaced
+    // by the identity of the reduction
+    template<class CalcType, size_t unroll_size, class _Value>
+    static inline void
+    accumulate_partial( _Value*       acc,
+                        const _Value& value,
+                        const size_t  count,
+                        const size_t  slot ) {
+        const std::array<CalcType, size> numbers = identities<CalcType>();
+        CalcType                         lanes[unroll_size];
+        for ( size_t i = 0; i < unroll_size; i++ ) {
+            lanes[i] = numbers[slot];
+        }
+        value.store_partial( lanes, count );
+        accumulate( acc, _Value::load( lanes ), slot );
+    }
+
+    template<class CalcType, class _Value>
+    static inline void
+    fold( std::array<CalcType, size>& results,
+          const std::array<_Value, size>& acc ) {
+        fold( results, acc, std::index_sequence_for<Ops...> {} );
+    }
+
+  private:
+    template<class _Value, size_t... I>
+    static inline void
+    accumulate( _Value*       acc,
+                const _Value& value,
+                const size_t  slot,
+                std::index_sequence<I...> ) {
+        ( ( slot == I ? (void)( acc[I].value = Ops::combine(
+                                        acc[I].value, value.value ) )
+                      : (void)0 ),
+          ... );
+    }
+
+    template<class CalcType, class _Value, size_t... I>
+    static inline void
+    fold( std::array<CalcType, size>&     results,
+          const std::array<_Value, size>& acc,
+          std::index_sequence<I...> ) {
+        ( ( results[I] = Ops::combine(
+                    results[I],
+                    (CalcType)Ops::horizontal( acc[I].value ) ) ),
+          ... );
+    }
+};
+
+// the reductions of a run_range. the range is only a chunk of the call
+// (compute_parallel, compute_mapped, compute_stream), so ctx.emit, which
+// packs from the first element of the data set, doesn't compile
+template<class Reduce>
+struct ranged : Reduce {
+    static const bool whole_range = false;
+};
+
+template<class CalcType, size_t extern_size, class Reduce = Reductions<>>
+struct State {
+    const std::array<CalcType*, extern_size> data_sets;
+    size_t                                   offset;
+    const size_t                             element_count;
+    // elements of the data sets, the bound of the offset loads. bigger than
+    // element_count for the chunks of compute_parallel
+    const size_t                             data_set_size;
+    std::array<CalcType, Reduce::size>       results;
+    // set by store_stream, the caller has to fence at the end
+    mutable bool streamed = false;
+    // elements written by emit to each data set
+    mutable std::array<size_t, extern_size> emitted {};
+};
+
+// software prefetch of every data set DISTANCE bytes ahead of the offset.
+// prefetches don't fault, so running past the end of a data set is fine
+template<size_t DISTANCE, class StateType>
+inline void
+prefetch( const StateType& state, const size_t delta = 0 ) {
+    for ( size_t i = 0; i < state.data_sets.size(); i++ ) {
+        _mm_prefetch( (const char*)state.data_sets[i] + state.offset + delta
+                              + DISTANCE,
+                      _MM_HINT_T0 );
+    }
+}
+
+// runs func on a masked or padded tail context, tail_lanes() is its count
+template<class Function, class TailContext>
+inline void
+run_tail( Function& func, TailContext& tail_ctx ) {
+    struct Reset {
+        ~Reset() { tail_lanes() = std::numeric_limits<size_t>::max(); }
+    } reset;
+    tail_lanes() = tail_ctx.count;
+    func( tail_ctx );
+}
+
+// non-temporal stores are weakly ordered. make them visible to other threads
+// before compute returns
+template<class StateType>
+inline void
+fence( const StateType& state ) {
+    if ( state.streamed ) {
+        _mm_sfence();
+    }
+}
+
+template<class CalcType,
+         size_t extern_size,
+         size_t unroll_size,
+         class Reduce = Reductions<>,
+         bool   partial = false,
+         bool   aligned = false>
+struct Context {
+    typedef Value<
+            CalcType,
+            unroll_size,
+            translation_types::simd_vec_size_is_in_lower_bound<
+                    CalcType,
                     unroll_size>::value>
             _Value;
 
-    State<CalcType, extern_size> const* state;
+    State<CalcType, extern_size, Reduce> const* state;
+    // accumulators of the current unroll level, one per reduction
+    _Value* accumulators;
+    // valid elements of a partial context (masked tail)
+    size_t count;
+    // bytes behind state->offset, the interleaved contexts of one loop step
+    // each work on their own block
+    size_t delta;
+    // copy of the data set pointers for load<I>() / store<I>(), a member of
+    // the context instead of a read through state. "Compute load<I>" in
+    // main.cpp times it against the runtime index
+    std::array<CalcType*, extern_size> bases;
+
+    inline CalcType*
+    pointer( const size_t index ) const {
+        return (CalcType*)( (size_t)( this->state->data_sets[index] )
+                            + this->state->offset + this->delta );
+    }
+
+    template<size_t index>
+    inline CalcType*
+    pointer() const {
+        static_assert( index < extern_size, "no data set with this index" );
+        return (CalcType*)( (char*)std::get<index>( this->bases )
+                            + this->state->offset + this->delta );
+    }
 
+    // aligned contexts work on padded data sets, a partial one still loads
+    // and stores the full vector, only accumulate skips the padding
     inline _Value
     load( const size_t index ) {
-        return _Value::load(
-                (CalcType*)( (size_t)( this->state->data_sets[index] )
-                             + this->state->offset ) );
+        return load_from( this->pointer( index ) );
     };
 
+    // the data set picked at compile time
+    template<size_t index>
+    inline _Value
+    load() {
+        return load_from( this->template pointer<index>() );
+    }
+
+    // the element element_offset away from the current one (a[i - 1],
+    // a[i + 1], ...). only vectors that reach outside of the data set are
+    // built lane by lane with the edge mode. skip trusts the caller for the
+    // lanes of the data set, the tail (masked or padded) still loads only
+    // count lanes, the padding doesn't reach element_offset further
+    inline _Value
+    load( const size_t    index,
+          const ptrdiff_t element_offset,
+          const edge_mode edge = edge_mode::clamp ) {
+        const CalcType* ptr = this->pointer( index ) + element_offset;
+        if ( edge == edge_mode::skip ) {
+            if constexpr ( partial ) {
+                return _Value::load_partial( ptr, this->count );
+            } else {
+                return _Value::load( ptr );
+            }
+        }
+        const ptrdiff_t size = this->state->data_set_size;
+        const ptrdiff_t first
+                = ( this->state->offset + this->delta ) / sizeof( CalcType )
+                  + element_offset;
+        if ( first >= 0 && first + (ptrdiff_t)unroll_size <= size ) {
+            return _Value::load( ptr );
+        }
+
+        const CalcType* data = this->state->data_sets[index];
+        CalcType        lanes[unroll_size];
+        for ( size_t i = 0; i < unroll_size; i++ ) {
+            const ptrdiff_t element = first + (ptrdiff_t)i;
+            if ( element >= 0 && element < size ) {
+                lanes[i] = data[element];
+            } else if ( edge == edge_mode::zero || size == 0 ) {
+                lanes[i] = CalcType( 0 );
+            } else {
+                lanes[i] = data[element < 0 ? 0 : size - 1];
+            }
+        }
+        return _Value::load( lanes );
+    }
+
     inline void
-    store( _Value& to_store, const size_t index ) {
-        to_store.store( (CalcType*)( (size_t)( this->state->data_sets[index] )
-                                     + this->state->offset ) );
+    store( const _Value& to_store, const size_t index ) {
+        store_to( to_store, this->pointer( index ) );
     }
 
     inline void
@@ -497,100 +2093,1169 @@ struct Context {
         store( tmp, index );
     }
 
-    Context( State<CalcType, extern_size>* state ) {
-        this->state = state;
+    template<size_t index>
+    inline void
+    store( const _Value& to_store ) {
+        store_to( to_store, this->template pointer<index>() );
     }
-};
 
-template<class CalcType, size_t extern_size, size_t unroll_size, bool>
-struct unroll_operation {
-    template<class Function>
-    static inline void
-    f( State<CalcType, extern_size>& state, Function& func ) {
-        Context<CalcType, extern_size, unroll_size> ctx( &state );
-        const size_t BLOCK_SIZE = unroll_size * sizeof( CalcType );
-        const size_t MAX_OFFSET
-                = state.element_count * sizeof( CalcType ) - BLOCK_SIZE;
+    template<size_t index>
+    inline void
+    store( const CalcType& to_store ) {
+        store<index>( _Value::from_number( to_store ) );
+    }
 
-        for ( ; state.offset <= MAX_OFFSET; state.offset += BLOCK_SIZE ) {
-            func( ctx );
+    // stores only the lanes where mask is set, the others stay untouched
+    inline void
+    store_if( const typename _Value::_Mask& mask,
+              const _Value&                 to_store,
+              const size_t                  index ) {
+        CalcType* ptr = this->pointer( index );
+        if constexpr ( partial && !aligned ) {
+            to_store.store_if_partial( ptr, mask, this->count );
+        } else {
+            to_store.store_if( ptr, mask );
         }
+    }
 
-        unroll_operation<
-                CalcType,
-                extern_size,
-                unroll_size / 2,
-                translation_types::simd_vec_size_is_in_lower_bound<
-                        CalcType,
-                        unroll_size / 2>::value>::f( state, func );
+    // appends the lanes where mask is set behind the elements emitted to
+    // data set index so far. the end never passes the current offset, so
+    // the data set can also be one that is loaded from
+    inline void
+    emit( const typename _Value::_Mask& mask,
+          const _Value&                 to_emit,
+          const size_t                  index ) {
+        static_assert( Reduce::whole_range,
+                       "ctx.emit isn't available in compute_parallel, "
+                       "compute_mapped and compute_stream" );
+        CalcType* ptr = this->state->data_sets[index]
+                        + this->state->emitted[index];
+        if constexpr ( partial ) {
+            this->state->emitted[index] += to_emit.compress_store_partial(
+                    ptr, mask, this->count );
+        } else {
+            this->state->emitted[index]
+                    += to_emit.compress_store( ptr, mask );
+        }
     }
-};
 
-template<class CalcType, size_t extern_size, size_t unroll_size>
-struct unroll_operation<CalcType, extern_size, unroll_size, false> {
-    template<class Function>
-    static inline void
-    f( State<CalcType, extern_size>& state, Function& func ) {
-        Context<CalcType, extern_size, unroll_size> ctx( &state );
+    // table[index] for every lane, index is a loaded integer value
+    template<class T>
+    inline auto
+    gather( const T*      table,
+            const _Value& index,
+            const size_t  table_size = 0 ) const {
+        const size_t count = partial ? this->count : unroll_size;
+        return gather_lanes( table, index, count, table_size );
+    }
+
+    // base[index] = value for every lane, the last lane wins on conflicts
+    template<class T, class ScatterValue>
+    inline void
+    scatter( T*                  base,
+             const _Value&       index,
+             const ScatterValue& value,
+             const size_t        table_size = 0 ) const {
+        const size_t count = partial ? this->count : unroll_size;
+        scatter_lanes( base, index, value, count, table_size );
+    }
+
+    // store that bypasses the cache, for big outputs that aren't read again
+    // soon. saves the read for ownership and doesn't evict the inputs
+    inline void
+    store_stream( const _Value& to_store, const size_t index ) {
+        CalcType* ptr = this->pointer( index );
+        if constexpr ( partial && !aligned ) {
+            to_store.store_partial( ptr, this->count );
+        } else if ( to_store.store_stream( ptr ) ) {
+            this->state->streamed = true;
+        }
+    }
+
+    // adds value to the reduction in slot (index in compute_reduce<...>)
+    inline void
+    accumulate( const _Value& value, const size_t slot ) {
+        if constexpr ( partial ) {
+            Reduce::template accumulate_partial<CalcType, unroll_size>(
+                    this->accumulators, value, this->count, slot );
+        } else {
+            Reduce::accumulate( this->accumulators, value, slot );
+        }
+    }
+
+    inline void
+    accumulate( const CalcType& value, const size_t slot ) {
+        accumulate( _Value::from_number( value ), slot );
+    }
+
+    Context( State<CalcType, extern_size, Reduce>* state,
+             _Value*                               accumulators,
+             const size_t                          count = unroll_size,
+             const size_t                          delta = 0 ) {
+        this->state = state;
+        this->accumulators = accumulators;
+        this->count = count;
+        this->delta = delta;
+        for ( size_t i = 0; i < extern_size; i++ ) {
+            this->bases[i] = state->data_sets[i];
+        }
+    }
+
+  private:
+    inline _Value
+    load_from( const CalcType* ptr ) const {
+        if constexpr ( aligned ) {
+            return _Value::load_a( ptr );
+        } else if constexpr ( partial ) {
+            return _Value::load_partial( ptr, this->count );
+        } else {
+            return _Value::load( ptr );
+        }
+    }
+
+    inline void
+    store_to( const _Value& to_store, CalcType* ptr ) const {
+        if constexpr ( aligned ) {
+            to_store.store_a( ptr );
+        } else if constexpr ( partial ) {
+            to_store.store_partial( ptr, this->count );
+        } else {
+            to_store.store( ptr );
+        }
+    }
+};
+
+// one context per interleaved block, each with its own accumulators so the
+// reductions of the blocks don't depend on each other
+template<class _Context,
+         size_t unroll_size,
+         class StateType,
+         class Accumulators,
+         size_t... I>
+inline std::array<_Context, sizeof...( I )>
+interleaved_contexts( StateType&    state,
+                      Accumulators& acc,
+                      std::index_sequence<I...> ) {
+    const size_t BLOCK_SIZE = unroll_size * sizeof( *state.data_sets[0] );
+    return { _Context(
+            &state, acc[I].data(), unroll_size, I * BLOCK_SIZE )... };
+}
+
+template<class CalcType, size_t extern_size, size_t unroll_size, bool>
+struct unroll_operation {
+    template<class Policy, class Reduce, class Function>
+    static inline void
+    f( State<CalcType, extern_size, Reduce>& state, Function& func ) {
+        const bool PADDED = Policy::tail == tail_mode::padded;
+        typedef Context<CalcType,
+                        extern_size,
+                        unroll_size,
+                        Reduce,
+                        false,
+                        PADDED>
+                _Context;
+        const size_t INTERLEAVE = Policy::interleave;
+        std::array<std::array<typename _Context::_Value, Reduce::size>,
+                   INTERLEAVE>
+                acc;
+        for ( auto& block_acc : acc ) {
+            Reduce::template init<CalcType>( block_acc );
+        }
+
+        std::array<_Context, INTERLEAVE> ctx
+                = interleaved_contexts<_Context, unroll_size>(
+                        state, acc, std::make_index_sequence<INTERLEAVE> {} );
+        const size_t BLOCK_SIZE = unroll_size * sizeof( CalcType );
+        const size_t STEP_SIZE = BLOCK_SIZE * INTERLEAVE;
+        const size_t END_OFFSET = state.element_count * sizeof( CalcType );
+
+        for ( ; state.offset + STEP_SIZE <= END_OFFSET;
+              state.offset += STEP_SIZE ) {
+            for ( size_t i = 0; i < INTERLEAVE; i++ ) {
+                if constexpr ( Policy::prefetch > 0 ) {
+                    prefetch<Policy::prefetch>( state, i * BLOCK_SIZE );
+                }
+                func( ctx[i] );
+            }
+        }
+
+        // the full blocks that don't fill a whole step
+        if constexpr ( INTERLEAVE > 1 ) {
+            for ( ; state.offset + BLOCK_SIZE <= END_OFFSET;
+                  state.offset += BLOCK_SIZE ) {
+                func( ctx[0] );
+            }
+        }
+
+        if constexpr ( Policy::tail == tail_mode::masked ) {
+            if ( state.offset < END_OFFSET ) {
+                Context<CalcType, extern_size, unroll_size, Reduce, true>
+                        tail_ctx(
+                                &state,
+                                acc[0].data(),
+                                ( END_OFFSET - state.offset )
+                                        / sizeof( CalcType ) );
+                run_tail( func, tail_ctx );
+                state.offset = END_OFFSET;
+            }
+        } else if constexpr ( PADDED ) {
+            if ( state.offset < END_OFFSET ) {
+                Context<CalcType, extern_size, unroll_size, Reduce, true, true>
+                        tail_ctx(
+                                &state,
+                                acc[0].data(),
+                                ( END_OFFSET - state.offset )
+                                        / sizeof( CalcType ) );
+                run_tail( func, tail_ctx );
+                state.offset = END_OFFSET;
+            }
+        }
+
+        for ( const auto& block_acc : acc ) {
+            Reduce::fold( state.results, block_acc );
+        }
+
+        if constexpr ( Policy::tail == tail_mode::cascade ) {
+            unroll_operation<
+                    CalcType,
+                    extern_size,
+                    unroll_size / 2,
+                    translation_types::simd_vec_size_is_in_lower_bound<
+                            CalcType,
+                            unroll_size / 2>::value>::
+                    template f<Policy>( state, func );
+        }
+    }
+};
+
+template<class CalcType, size_t extern_size, size_t unroll_size>
+struct unroll_operation<CalcType, extern_size, unroll_size, false> {
+    template<class Policy, class Reduce, class Function>
+    static inline void
+    f( State<CalcType, extern_size, Reduce>& state, Function& func ) {
+        typedef Context<CalcType, extern_size, unroll_size, Reduce> _Context;
+        std::array<typename _Context::_Value, Reduce::size> acc;
+        Reduce::template init<CalcType>( acc );
+
+        _Context     ctx( &state, acc.data() );
+        const size_t max_offset = state.element_count * sizeof( CalcType );
+
+        for ( ; state.offset < max_offset;
+              state.offset += sizeof( CalcType ) ) {
+            func( ctx );
+        }
+
+        Reduce::fold( state.results, acc );
+    }
+};
+
+template<class CalcType,
+         size_t external_size,
+         class Function,
+         class Policy = policy<>>
+void
+run( std::array<CalcType*, external_size> data_sets,
+     const size_t                         element_count,
+     Function                             func,
+     Policy = {} ) {
+    State<CalcType, external_size> state { .data_sets = data_sets,
+                                           .offset = 0,
+                                           .element_count = element_count,
+                                           .data_set_size = element_count,
+                                           .results = {} };
+
+    unroll_operation<
+            CalcType,
+            external_size,
+            translation_types::simd_vec_sizes<CalcType>::max,
+            translation_types::simd_vec_size_is_in_lower_bound<
+                    CalcType,
+                    translation_types::simd_vec_sizes<CalcType>::max>::value>::
+            template f<Policy>( state, func );
+    fence( state );
+}
+
+// runs [begin, end) of the data_sets. begin has to be a multiple of the
+// widest simd size, so only the range containing the end reaches the tail
+template<class Policy,
+         class CalcType,
+         size_t external_size,
+         class Function>
+void
+run_range( std::array<CalcType*, external_size> data_sets,
+           const size_t                         begin,
+           const size_t                         end,
+           const size_t                         data_set_size,
+           Function&                            func ) {
+    State<CalcType, external_size, ranged<Reductions<>>> state {
+        .data_sets = data_sets,
+        .offset = begin * sizeof( CalcType ),
+        .element_count = end,
+        .data_set_size = data_set_size,
+        .results = {}
+    };
+
+    unroll_operation<
+            CalcType,
+            external_size,
+            translation_types::simd_vec_sizes<CalcType>::max,
+            translation_types::simd_vec_size_is_in_lower_bound<
+                    CalcType,
+                    translation_types::simd_vec_sizes<CalcType>::max>::value>::
+            template f<Policy>( state, func );
+    fence( state );
+}
+
+template<class Allocator>
+struct is_padded : std::false_type {};
+template<class T>
+struct is_padded<padded_allocator<T>> : std::true_type {};
+template<class T>
+struct is_padded<default_init_allocator<T, padded_allocator<T>>> :
+        std::true_type {};
+
+// run for add / sub / mul / div. if every vector is a vecex::vector it skips
+// the tail handling, but only if the result ends at element_count. otherwise
+// the last padded vector would overwrite elements of the result
+template<class... Allocators,
+         class CalcType,
+         size_t external_size,
+         class Function>
+void
+run_vectors( std::array<CalcType*, external_size> data_sets,
+             const size_t                         element_count,
+             const size_t                         result_size,
+             Function                             func ) {
+    if constexpr ( ( is_padded<Allocators>::value && ... ) ) {
+        if ( result_size == element_count ) {
+            run( data_sets,
+                 element_count,
+                 func,
+                 policy<tail_mode::padded> {} );
+            return;
+        }
+    }
+    run( data_sets, element_count, func );
+}
+
+//
+// compute over data sets with different element types. every data set uses
+// the same amount of lanes, the widest simd size of the widest type. so float
+// with unsigned char runs as Vec16f with Vec16uc. if a type has no simd
+// vector with that many lanes, all data sets fall back to single elements
+//
+template<class... Types>
+struct mixed_sizes {
+    static constexpr size_t
+    smallest_max() {
+        size_t result = std::numeric_limits<size_t>::max();
+        for ( size_t size :
+              { translation_types::simd_vec_sizes<Types>::max... } ) {
+            result = size < result ? size : result;
+        }
+        return result;
+    }
+
+    static const size_t max = smallest_max();
+};
+
+template<size_t unroll_size, class... Types>
+struct mixed_is_simd {
+    static const bool value
+            = ( translation_types::simd_vec_size_is_in_lower_bound<
+                        Types,
+                        unroll_size>::value
+                && ... );
+};
+
+// the access of every data set of a compute with mixed types
+template<access... ACCESS>
+struct access_list {
+    template<size_t index>
+    static constexpr access
+    get() {
+        constexpr access list[] = { ACCESS..., access::inout };
+        return list[index];
+    }
+};
+
+template<class T>
+struct data_set_traits;
+
+// plain pointers are loaded and stored
+template<class T>
+struct data_set_traits<T*> {
+    typedef T           type;
+    static const access value = access::inout;
+    static inline T*
+    pointer( T* ptr ) {
+        return ptr;
+    }
+};
+template<class T, access ACCESS>
+struct data_set_traits<data_set<T, ACCESS>> {
+    typedef T           type;
+    static const access value = ACCESS;
+    static inline T*
+    pointer( const data_set<T, ACCESS>& set ) {
+        return set.pointer;
+    }
+};
+
+// out data sets of calls that move more bytes than this are stored
+// non-temporal, they wouldn't stay in the cache anyway
+static const size_t stream_out_bytes = 1 << 24;
+
+template<class Access, class... Types>
+struct MixedState {
+    const std::tuple<Types*...> data_sets;
+    // in elements, not in bytes. the element sizes differ
+    size_t       offset;
+    const size_t element_count;
+    // store the out data sets with store_stream
+    const bool stream_out;
+    // set by store_stream, the caller has to fence at the end
+    mutable bool streamed = false;
+};
+
+// out data sets are never read, prefetching them only costs bandwidth
+template<size_t DISTANCE, class Access, class... Types, size_t... I>
+inline void
+mixed_prefetch( const MixedState<Access, Types...>& state,
+                std::index_sequence<I...> ) {
+    ( ( Access::template get<I>() == access::out
+                ? (void)0
+                : _mm_prefetch( (const char*)( std::get<I>( state.data_sets )
+                                               + state.offset )
+                                        + DISTANCE,
+                                _MM_HINT_T0 ) ),
+      ... );
+}
+
+template<size_t DISTANCE, class Access, class... Types>
+inline void
+mixed_prefetch( const MixedState<Access, Types...>& state ) {
+    mixed_prefetch<DISTANCE>( state, std::index_sequence_for<Types...> {} );
+}
+
+template<size_t unroll_size,
+         bool   partial,
+         bool   aligned,
+         class Access,
+         class... Types>
+struct MixedContext {
+    template<size_t index>
+    using _Type = std::tuple_element_t<index, std::tuple<Types...>>;
+
+    template<size_t index>
+    using _Value = Value<_Type<index>,
+                         unroll_size,
+                         mixed_is_simd<unroll_size, Types...>::value>;
+
+    MixedState<Access, Types...> const* state;
+    // valid elements of a partial context (masked tail)
+    size_t count;
+
+    template<size_t index>
+    inline _Value<index>
+    load() {
+        static_assert( Access::template get<index>() != access::out,
+                       "the data set is vecex::out, it can't be loaded" );
+        const _Type<index>* ptr = std::get<index>( this->state->data_sets )
+                                  + this->state->offset;
+        if constexpr ( aligned ) {
+            return _Value<index>::load_a( ptr );
+        } else if constexpr ( partial ) {
+            return _Value<index>::load_partial( ptr, this->count );
+        } else {
+            return _Value<index>::load( ptr );
+        }
+    }
+
+    template<size_t index>
+    inline void
+    store( const _Value<index>& to_store ) {
+        static_assert( Access::template get<index>() != access::in,
+                       "the data set is vecex::in, it can't be stored" );
+        if constexpr ( Access::template get<index>() == access::out ) {
+            if ( this->state->stream_out ) {
+                store_stream<index>( to_store );
+                return;
+            }
+        }
+        _Type<index>* ptr = std::get<index>( this->state->data_sets )
+                            + this->state->offset;
+        if constexpr ( aligned ) {
+            to_store.store_a( ptr );
+        } else if constexpr ( partial ) {
+            to_store.store_partial( ptr, this->count );
+        } else {
+            to_store.store( ptr );
+        }
+    }
+
+    template<size_t index>
+    inline void
+    store( const _Type<index>& to_store ) {
+        store<index>( _Value<index>::from_number( to_store ) );
+    }
+
+    template<size_t index>
+    inline void
+    store_if( const typename _Value<index>::_Mask& mask,
+              const _Value<index>&                 to_store ) {
+        static_assert( Access::template get<index>() != access::in,
+                       "the data set is vecex::in, it can't be stored" );
+        _Type<index>* ptr = std::get<index>( this->state->data_sets )
+                            + this->state->offset;
+        if constexpr ( partial && !aligned ) {
+            to_store.store_if_partial( ptr, mask, this->count );
+        } else {
+            to_store.store_if( ptr, mask );
+        }
+    }
+
+    // table[index] for every lane, index is a value of an integer data set
+    template<class T, class IndexValue>
+    inline auto
+    gather( const T*          table,
+            const IndexValue& index,
+            const size_t      table_size = 0 ) const {
+        const size_t count = partial ? this->count : unroll_size;
+        return gather_lanes( table, index, count, table_size );
+    }
+
+    // base[index] = value for every lane, the last lane wins on conflicts
+    template<class T, class IndexValue, class ScatterValue>
+    inline void
+    scatter( T*                  base,
+             const IndexValue&   index,
+             const ScatterValue& value,
+             const size_t        table_size = 0 ) const {
+        const size_t count = partial ? this->count : unroll_size;
+        scatter_lanes( base, index, value, count, table_size );
+    }
+
+    template<size_t index>
+    inline void
+    store_stream( const _Value<index>& to_store ) {
+        static_assert( Access::template get<index>() != access::in,
+                       "the data set is vecex::in, it can't be stored" );
+        _Type<index>* ptr = std::get<index>( this->state->data_sets )
+                            + this->state->offset;
+        if constexpr ( partial && !aligned ) {
+            to_store.store_partial( ptr, this->count );
+        } else if ( to_store.store_stream( ptr ) ) {
+            this->state->streamed = true;
+        }
+    }
+
+    MixedContext( MixedState<Access, Types...>* state,
+                  const size_t                  count = unroll_size ) {
+        this->state = state;
+        this->count = count;
+    }
+};
+
+template<size_t unroll_size, bool>
+struct mixed_unroll_operation {
+    template<class Policy, class Function, class Access, class... Types>
+    static inline void
+    f( MixedState<Access, Types...>& state, Function& func ) {
+        const bool PADDED = Policy::tail == tail_mode::padded;
+        MixedContext<unroll_size, false, PADDED, Access, Types...> ctx(
+                &state );
+
+        for ( ; state.offset + unroll_size <= state.element_count;
+              state.offset += unroll_size ) {
+            if constexpr ( Policy::prefetch > 0 ) {
+                mixed_prefetch<Policy::prefetch>( state );
+            }
+            func( ctx );
+        }
+
+        if constexpr ( PADDED ) {
+            // all data sets are padded to 64 bytes, so the last block fits.
+            // the count keeps gather / scatter out of the padding
+            if ( state.offset < state.element_count ) {
+                MixedContext<unroll_size, true, true, Access, Types...>
+                        tail_ctx(
+                        &state, state.element_count - state.offset );
+                run_tail( func, tail_ctx );
+                state.offset = state.element_count;
+            }
+        } else if constexpr ( Policy::tail == tail_mode::masked ) {
+            if ( state.offset < state.element_count ) {
+                MixedContext<unroll_size, true, false, Access, Types...>
+                        tail_ctx(
+                        &state, state.element_count - state.offset );
+                run_tail( func, tail_ctx );
+                state.offset = state.element_count;
+            }
+        } else {
+            mixed_unroll_operation<
+                    unroll_size / 2,
+                    mixed_is_simd<unroll_size / 2, Types...>::value>::
+                    template f<Policy>( state, func );
+        }
+    }
+};
+
+template<size_t unroll_size>
+struct mixed_unroll_operation<unroll_size, false> {
+    template<class Policy, class Function, class Access, class... Types>
+    static inline void
+    f( MixedState<Access, Types...>& state, Function& func ) {
+        MixedContext<unroll_size, false, false, Access, Types...> ctx(
+                &state );
+
+        for ( ; state.offset < state.element_count; state.offset++ ) {
+            func( ctx );
+        }
+    }
+};
+
+};    // namespace compute
+
+namespace parallel {
+
+// smallest range a single worker gets. below that the wakeup of the workers
+// costs more than it saves
+static const size_t min_chunk_elements = 1 << 14;
+
+// persistent worker threads. they are started once on the first use and
+// sleep until the next run(). the calling thread always works on task 0, so
+// a pool with n workers runs up to n + 1 tasks at once. a run() from inside
+// a task (e.g. compute_parallel in a compute_stream lambda) runs its tasks
+// one after another on the current thread
+class Pool {
+  public:
+    static Pool&
+    instance() {
+        static Pool pool( std::thread::hardware_concurrency() > 1
+                                  ? std::thread::hardware_concurrency() - 1
+                                  : 0 );
+        return pool;
+    }
+
+    size_t
+    max_tasks() const {
+        return this->workers.size() + 1;
+    }
+
+    // calls task( i ) for every i < task_count and returns after all of them
+    // are done. task_count has to be <= max_tasks(). the first exception of
+    // a task is rethrown here, after every task finished
+    template<class Task>
+    void
+    run( const size_t task_count, Task& task ) {
+        if ( in_task() ) {
+            for ( size_t i = 0; i < task_count; i++ ) {
+                task( i );
+            }
+            return;
+        }
+
+        std::lock_guard<std::mutex> run_lock( this->run_mutex );
+        {
+            std::lock_guard<std::mutex> lock( this->mutex );
+            this->job = &Pool::invoke<Task>;
+            this->job_data = &task;
+            this->task_count = task_count;
+            this->pending = task_count - 1;
+            this->error = nullptr;
+            this->generation++;
+        }
+        this->wake.notify_all();
+
+        in_task() = true;
+        try {
+            task( 0 );
+        } catch ( ... ) {
+            fail( std::current_exception() );
+        }
+        in_task() = false;
+
+        std::unique_lock<std::mutex> lock( this->mutex );
+        this->done.wait( lock, [this] { return this->pending == 0; } );
+        if ( this->error ) {
+            std::rethrow_exception( std::exchange( this->error, nullptr ) );
+        }
+    }
+
+    Pool( const Pool& ) = delete;
+    Pool&
+    operator=( const Pool& ) = delete;
+
+    ~Pool() {
+        {
+            std::lock_guard<std::mutex> lock( this->mutex );
+            this->stop = true;
+        }
+        this->wake.notify_all();
+        for ( auto& worker : this->workers ) {
+            worker.join();
+        }
+    }
+
+  private:
+    explicit Pool( const size_t worker_count ) {
+        for ( size_t i = 0; i < worker_count; i++ ) {
+            this->workers.emplace_back( [this, i] { this->work( i + 1 ); } );
+        }
+    }
+
+    template<class Task>
+    static void
+    invoke( void* task, const size_t index ) {
+        ( *static_cast<Task*>( task ) )( index );
+    }
+
+    // true while the current thread works on a task of any run()
+    static bool&
+    in_task() {
+        static thread_local bool flag = false;
+        return flag;
+    }
+
+    // keeps the first exception of the current run()
+    void
+    fail( std::exception_ptr exception ) {
+        std::lock_guard<std::mutex> lock( this->mutex );
+        if ( !this->error ) {
+            this->error = exception;
+        }
+    }
+
+    void
+    work( const size_t index ) {
+        in_task() = true;
+        size_t seen = 0;
+        for ( ;; ) {
+            void ( *current_job )( void*, size_t );
+            void* current_data;
+            {
+                std::unique_lock<std::mutex> lock( this->mutex );
+                this->wake.wait( lock, [&] {
+                    return this->stop || this->generation != seen;
+                } );
+                if ( this->stop ) {
+                    return;
+                }
+                seen = this->generation;
+                if ( index >= this->task_count ) {
+                    continue;
+                }
+                current_job = this->job;
+                current_data = this->job_data;
+            }
+
+            try {
+                current_job( current_data, index );
+            } catch ( ... ) {
+                fail( std::current_exception() );
+            }
+
+            std::lock_guard<std::mutex> lock( this->mutex );
+            if ( --this->pending == 0 ) {
+                this->done.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex               run_mutex;
+    std::mutex               mutex;
+    std::condition_variable  wake;
+    std::condition_variable  done;
+    void ( *job )( void*, size_t ) = nullptr;
+    void*  job_data = nullptr;
+    size_t task_count = 0;
+    size_t pending = 0;
+    size_t generation = 0;
+    bool   stop = false;
+
+    std::exception_ptr error;
+};
+
+};    // namespace parallel
+
+};    // namespace internal
+
+// division of many elements by the same number. for integers the multiplier
+// and shift of the vectorclass Divisor are calculated once here instead of
+// for every simd vector. capture it in the lambda: ctx.load( 0 ) / d
+template<class CalcType>
+struct divisor {
+    typedef typename internal::translation_types::divisor_type<CalcType>::type
+             simd_type;
+    CalcType  number;
+    simd_type simd;
+
+    divisor( const CalcType number ) :
+            number( number ), simd( divisor_of( number ) ) {}
+
+  private:
+    static inline simd_type
+    divisor_of( const CalcType number ) {
+        if constexpr ( std::is_same<simd_type, CalcType>::value ) {
+            return number;
+        } else {
+            return simd_type( number );
+        }
+    }
+};
+
+namespace helper {
+
+template<class head, class Allocator>
+size_t
+element_count_min( const std::vector<head, Allocator>& h ) {
+    return h.size();
+}
+
+template<class head, class Allocator, class... tail>
+size_t
+element_count_min( const std::vector<head, Allocator>& h, const tail&... t ) {
+    const size_t min = element_count_min( t... );
+    const size_t current_size = h.size();
+    return min < current_size ? min : current_size;
+}
+}    // namespace helper
+
+// returns the count of elements emitted to each data set (ctx.emit)
+template<class CalcType,
+         size_t external_size,
+         class Function,
+         class Policy = policy<>>
+std::array<size_t, external_size>
+compute( std::array<CalcType*, external_size> data_sets,
+         const size_t                         element_count,
+         Function                             func,
+         Policy = {} ) {
+    internal::compute::State<CalcType, external_size> state {
+        .data_sets = data_sets,
+        .offset = 0,
+        .element_count = element_count,
+        .data_set_size = element_count,
+        .results = {}
+    };
+
+    internal::compute::unroll_operation<
+            CalcType,
+            external_size,
+            internal::translation_types::simd_vec_sizes<CalcType>::max,
+            internal::translation_types::simd_vec_size_is_in_lower_bound<
+                    CalcType,
+                    internal::translation_types::simd_vec_sizes<
+                            CalcType>::max>::value>::
+            template f<Policy>( state, func );
+    internal::compute::fence( state );
+    return state.emitted;
+}
+
+// mixed element types: std::tuple { a.data(), b.data() } with a and b of
+// different types. the lambda uses ctx.load<I>() / ctx.store<I>( value ).
+// the pointers can be tagged: std::tuple { vecex::in( a.data() ), ... }
+template<class... Sets, class Function, class Policy = policy<>>
+void
+compute( std::tuple<Sets...> data_sets,
+         const size_t        element_count,
+         Function            func,
+         Policy = {} ) {
+    using namespace internal::compute;
+    typedef mixed_sizes<typename data_set_traits<Sets>::type...> sizes;
+    typedef access_list<data_set_traits<Sets>::value...>         Access;
+    const size_t BYTES
+            = element_count
+              * ( sizeof( typename data_set_traits<Sets>::type ) + ... );
+
+    MixedState<Access, typename data_set_traits<Sets>::type...> state {
+        .data_sets = std::apply(
+                []( const Sets&... sets ) {
+                    return std::make_tuple(
+                            data_set_traits<Sets>::pointer( sets )... );
+                },
+                data_sets ),
+        .offset = 0,
+        .element_count = element_count,
+        .stream_out = BYTES > stream_out_bytes
+    };
+
+    mixed_unroll_operation<
+            sizes::max,
+            mixed_is_simd<sizes::max,
+                          typename data_set_traits<Sets>::type...>::value>::
+            template f<Policy>( state, func );
+    fence( state );
+}
+
+// ctx.load<I>() inside a generic lambda has to be written as
+// ctx.template load<I>(). these do the same without the template keyword
+template<size_t index, class Context>
+inline auto
+load( Context& ctx ) {
+    return ctx.template load<index>();
+}
+
+template<size_t index, class Context, class ValueType>
+inline void
+store( Context& ctx, const ValueType& value ) {
+    ctx.template store<index>( value );
+}
+
+namespace internal {
+namespace conversion {
+
+// integer with twice / half the width and the same signedness
+template<class T>
+struct wider {};
+template<>
+struct wider<char> {
+    typedef short type;
+};
+template<>
+struct wider<unsigned char> {
+    typedef unsigned short type;
+};
+template<>
+struct wider<short> {
+    typedef int type;
+};
+template<>
+struct wider<unsigned short> {
+    typedef unsigned int type;
+};
+template<>
+struct wider<int> {
+    typedef long type;
+};
+template<>
+struct wider<unsigned int> {
+    typedef unsigned long type;
+};
+
+template<class T>
+struct narrower {};
+template<>
+struct narrower<short> {
+    typedef char type;
+};
+template<>
+struct narrower<unsigned short> {
+    typedef unsigned char type;
+};
+template<>
+struct narrower<int> {
+    typedef short type;
+};
+template<>
+struct narrower<unsigned int> {
+    typedef unsigned short type;
+};
+template<>
+struct narrower<long> {
+    typedef int type;
+};
+template<>
+struct narrower<unsigned long> {
+    typedef unsigned int type;
+};
+
+template<class T, size_t lanes>
+struct has_simd_vec {
+    typedef translation_types::simd_vec_sizes<T> sizes;
+    static const bool value = sizes::min <= lanes && lanes <= sizes::max;
+};
+
+// the integer a float / double is truncated to
+template<class T>
+using truncated = typename std::conditional<sizeof( T ) == 4, int, long>::type;
+
+// true if vec() converts with vectorclass instructions. the steps: integers
+// widen with extend_low / extend_high and narrow with compress one width at
+// a time, signedness changes at the same width. int and long go to float
+// and double with to_float / to_double, back with truncatei. everything
+// else (e.g. unsigned int to float, where the signed instructions would be
+// wrong) converts lane by lane
+template<class To, class From, size_t lanes>
+constexpr bool
+supported() {
+    if constexpr ( !has_simd_vec<From, lanes>::value
+                   || !has_simd_vec<To, lanes>::value ) {
+        return false;
+    } else if constexpr ( std::is_same<From, To>::value ) {
+        return true;
+    } else if constexpr ( std::is_integral<From>::value
+                          && std::is_integral<To>::value ) {
+        if constexpr ( sizeof( From ) == sizeof( To ) ) {
+            return true;
+        } else if constexpr ( sizeof( From ) < sizeof( To ) ) {
+            return supported<To, typename wider<From>::type, lanes>();
+        } else {
+            return supported<To, typename narrower<From>::type, lanes>();
+        }
+    } else if constexpr ( std::is_integral<From>::value ) {
+        if constexpr ( sizeof( From ) < 4 ) {
+            return supported<int, From, lanes>()
+                && supported<To, int, lanes>();
+        } else {
+            return std::is_same<From, int>::value
+                || ( std::is_same<From, long>::value
+                     && std::is_same<To, double>::value );
+        }
+    } else if constexpr ( std::is_integral<To>::value ) {
+        return supported<To, truncated<From>, lanes>();
+    } else {
+        return true;
+    }
+}
+
+// only called if supported<To, From, lanes>()
+template<class To, class From, size_t lanes>
+inline translation_types::simd_vec_type_t<To, lanes>
+vec( const translation_types::simd_vec_type_t<From, lanes>& value ) {
+    typedef translation_types::simd_vec_type_t<To, lanes> _To;
+    if constexpr ( std::is_same<From, To>::value ) {
+        return value;
+    } else if constexpr ( std::is_integral<From>::value
+                          && std::is_integral<To>::value ) {
+        if constexpr ( sizeof( From ) == sizeof( To ) ) {
+            return _To( value );
+        } else if constexpr ( sizeof( From ) < sizeof( To ) ) {
+            typedef typename wider<From>::type Wide;
+            return vec<To, Wide, lanes>(
+                    translation_types::simd_vec_type_t<Wide, lanes>(
+                            extend_low( value ), extend_high( value ) ) );
+        } else {
+            typedef typename narrower<From>::type Narrow;
+            return vec<To, Narrow, lanes>(
+                    translation_types::simd_vec_type_t<Narrow, lanes>(
+                            compress( value.get_low(),
+                                      value.get_high() ) ) );
+        }
+    } else if constexpr ( std::is_integral<From>::value ) {
+        if constexpr ( sizeof( From ) < 4 ) {
+            return vec<To, int, lanes>( vec<int, From, lanes>( value ) );
+        } else if constexpr ( std::is_same<To, float>::value ) {
+            return to_float( value );
+        } else {
+            return to_double( value );
+        }
+    } else if constexpr ( std::is_integral<To>::value ) {
+        return vec<To, truncated<From>, lanes>( truncatei( value ) );
+    } else if constexpr ( std::is_same<To, float>::value ) {
+        return to_float( value );
+    } else {
+        return to_double( value );
+    }
+}
 
-        const size_t max_offset = state.element_count * sizeof( CalcType );
+}    // namespace conversion
+}    // namespace internal
 
-        for ( ; state.offset < max_offset;
-              state.offset += sizeof( CalcType ) ) {
-            func( ctx );
+// converts a Value of a mixed compute to another element type with the same
+// amount of lanes: vecex::convert<float>( vecex::load<0>( ctx ) ). integer
+// widths and int / long <-> float / double use the vectorclass conversions
+// (see internal::conversion::supported), the rest goes lane by lane
+template<class To, class From, size_t unroll_size, bool simd>
+inline internal::compute::Value<To, unroll_size, simd>
+convert( const internal::compute::Value<From, unroll_size, simd>& value ) {
+    typedef internal::compute::Value<To, unroll_size, simd> _Result;
+    if constexpr ( !simd ) {
+        return _Result { (To)value.value };
+    } else if constexpr ( internal::conversion::
+                                  supported<To, From, unroll_size>() ) {
+        return _Result { internal::conversion::vec<To, From, unroll_size>(
+                value.value ) };
+    } else {
+        From from[unroll_size];
+        To   to[unroll_size];
+        value.store( from );
+        for ( size_t i = 0; i < unroll_size; i++ ) {
+            to[i] = (To)from[i];
         }
+        return _Result::load( to );
     }
-};
-
-template<class CalcType, size_t external_size, class Function>
-void
-run( std::array<CalcType*, external_size> data_sets,
-     const size_t                         element_count,
-     Function                             func ) {
-    State<CalcType, external_size> state { .data_sets = data_sets,
-                                           .offset = 0,
-                                           .element_count = element_count };
+}
 
-    unroll_operation<
-            CalcType,
-            external_size,
-            translation_types::simd_vec_sizes<CalcType>::max,
-            translation_types::simd_vec_size_is_in_lower_bound<
-                    CalcType,
-                    translation_types::simd_vec_sizes<CalcType>::max>::value>::
-            f( state, func );
+// per lane: mask ? a : b. branch free, a and b are both calculated
+template<class CalcType, size_t unroll_size, bool simd>
+inline internal::compute::Value<CalcType, unroll_size, simd>
+select( const internal::compute::Mask<CalcType, unroll_size, simd>&  mask,
+        const internal::compute::Value<CalcType, unroll_size, simd>& a,
+        const internal::compute::Value<CalcType, unroll_size, simd>& b ) {
+    if constexpr ( simd ) {
+        return { internal::math::select_of( mask.value, a.value, b.value ) };
+    } else {
+        return { mask.value ? a.value : b.value };
+    }
 }
 
-};    // namespace compute
+// the number isn't deduced (common_type_t), so select( m, x, 10 ) also works
+// for float values
+template<class CalcType, size_t unroll_size, bool simd>
+inline internal::compute::Value<CalcType, unroll_size, simd>
+select( const internal::compute::Mask<CalcType, unroll_size, simd>&  mask,
+        const internal::compute::Value<CalcType, unroll_size, simd>& a,
+        const std::common_type_t<CalcType>&                          b ) {
+    typedef internal::compute::Value<CalcType, unroll_size, simd> _Value;
+    return select( mask, a, _Value::from_number( b ) );
+}
 
-};    // namespace internal
+template<class CalcType, size_t unroll_size, bool simd>
+inline internal::compute::Value<CalcType, unroll_size, simd>
+select( const internal::compute::Mask<CalcType, unroll_size, simd>&  mask,
+        const std::common_type_t<CalcType>&                          a,
+        const internal::compute::Value<CalcType, unroll_size, simd>& b ) {
+    typedef internal::compute::Value<CalcType, unroll_size, simd> _Value;
+    return select( mask, _Value::from_number( a ), b );
+}
 
-namespace helper {
+// per lane: mask ? a + b : a, b is a value or a number
+template<class CalcType, size_t unroll_size, bool simd, class B>
+inline internal::compute::Value<CalcType, unroll_size, simd>
+if_add( const internal::compute::Mask<CalcType, unroll_size, simd>&  mask,
+        const internal::compute::Value<CalcType, unroll_size, simd>& a,
+        const B&                                                     b ) {
+    return select( mask, a + b, a );
+}
 
-template<class head>
-size_t
-element_count_min( const std::vector<head>& h ) {
-    return h.size();
+// per lane: mask ? a - b : a, b is a value or a number
+template<class CalcType, size_t unroll_size, bool simd, class B>
+inline internal::compute::Value<CalcType, unroll_size, simd>
+if_sub( const internal::compute::Mask<CalcType, unroll_size, simd>&  mask,
+        const internal::compute::Value<CalcType, unroll_size, simd>& a,
+        const B&                                                     b ) {
+    return select( mask, a - b, a );
 }
 
-template<class head, class... tail>
-size_t
-element_count_min( const std::vector<head>& h, const tail&... t ) {
-    const size_t min = element_count_min( t... );
-    const size_t current_size = h.size();
-    return min < current_size ? min : current_size;
+// per lane: mask ? a * b : a, b is a value or a number
+template<class CalcType, size_t unroll_size, bool simd, class B>
+inline internal::compute::Value<CalcType, unroll_size, simd>
+if_mul( const internal::compute::Mask<CalcType, unroll_size, simd>&  mask,
+        const internal::compute::Value<CalcType, unroll_size, simd>& a,
+        const B&                                                     b ) {
+    return select( mask, a * b, a );
 }
-}    // namespace helper
 
-template<class CalcType, size_t external_size, class Function>
-void
-compute( std::array<CalcType*, external_size> data_sets,
-         const size_t                         element_count,
-         Function                             func ) {
-    internal::compute::State<CalcType, external_size> state {
+template<class... Ops,
+         class CalcType,
+         size_t external_size,
+         class Function,
+         class Policy = policy<>>
+std::array<CalcType, sizeof...( Ops )>
+compute_reduce( std::array<CalcType*, external_size> data_sets,
+                const size_t                         element_count,
+                Function                             func,
+                Policy = {} ) {
+    typedef internal::compute::Reductions<Ops...> Reduce;
+    internal::compute::State<CalcType, external_size, Reduce> state {
         .data_sets = data_sets,
         .offset = 0,
-        .element_count = element_count
+        .element_count = element_count,
+        .data_set_size = element_count,
+        .results = Reduce::template identities<CalcType>()
     };
 
     internal::compute::unroll_operation<
@@ -600,17 +3265,67 @@ compute( std::array<CalcType*, external_size> data_sets,
             internal::translation_types::simd_vec_size_is_in_lower_bound<
                     CalcType,
                     internal::translation_types::simd_vec_sizes<
-                            CalcType>::max>::value>::f( state, func );
+                            CalcType>::max>::value>::
+            template f<Policy>( state, func );
+    internal::compute::fence( state );
+    return state.results;
 }
 
-template<class CalcType>
-std::vector<CalcType>
-add( std::vector<CalcType>& a, std::vector<CalcType>& b ) {
-    const size_t          element_count = helper::element_count_min( a, b );
-    std::vector<CalcType> result( element_count );
-    internal::compute::run(
+template<class CalcType,
+         size_t external_size,
+         class Function,
+         class Policy = policy<>>
+void
+compute_parallel( std::array<CalcType*, external_size> data_sets,
+                  const size_t                         element_count,
+                  Function                             func,
+                  const size_t                         thread_count = 0,
+                  Policy                                = {} ) {
+    auto&        pool = internal::parallel::Pool::instance();
+    const size_t SIMD_SIZE
+            = internal::translation_types::simd_vec_sizes<CalcType>::max;
+
+    size_t tasks = thread_count == 0 ? pool.max_tasks() : thread_count;
+    tasks = tasks < pool.max_tasks() ? tasks : pool.max_tasks();
+    const size_t max_tasks
+            = element_count / internal::parallel::min_chunk_elements;
+    tasks = tasks < max_tasks ? tasks : max_tasks;
+
+    if ( tasks <= 1 ) {
+        internal::compute::run_range<Policy>(
+                data_sets, 0, element_count, element_count, func );
+        return;
+    }
+
+    // every chunk starts on a multiple of the widest simd size, so only the
+    // last one has to handle the tail
+    size_t chunk = ( element_count + tasks - 1 ) / tasks;
+    chunk = ( chunk + SIMD_SIZE - 1 ) / SIMD_SIZE * SIMD_SIZE;
+
+    auto task = [&]( const size_t index ) {
+        const size_t begin = index * chunk;
+        const size_t end = begin + chunk < element_count ? begin + chunk
+                                                         : element_count;
+        if ( begin >= end ) {
+            return;
+        }
+        Function worker_func = func;
+        internal::compute::run_range<Policy>(
+                data_sets, begin, end, element_count, worker_func );
+    };
+    pool.run( tasks, task );
+}
+
+template<class CalcType, class Allocator, class AllocatorB>
+std::vector<CalcType, Allocator>
+add( std::vector<CalcType, Allocator>&  a,
+     std::vector<CalcType, AllocatorB>& b ) {
+    const size_t element_count = helper::element_count_min( a, b );
+    std::vector<CalcType, Allocator> result( element_count );
+    internal::compute::run_vectors<Allocator, AllocatorB>(
             std::array { a.data(), b.data(), result.data() },
             element_count,
+            result.size(),
             []( auto& ctx ) {
                 auto a_i = ctx.load( 0 );
                 auto b_i = ctx.load( 1 );
@@ -620,14 +3335,15 @@ add( std::vector<CalcType>& a, std::vector<CalcType>& b ) {
     return result;
 }
 
-template<class CalcType>
-std::vector<CalcType>
-add( std::vector<CalcType>& a, const CalcType& b ) {
-    const size_t          element_count = helper::element_count_min( a );
-    std::vector<CalcType> result( element_count );
-    internal::compute::run(
+template<class CalcType, class Allocator>
+std::vector<CalcType, Allocator>
+add( std::vector<CalcType, Allocator>& a, const CalcType& b ) {
+    const size_t element_count = helper::element_count_min( a );
+    std::vector<CalcType, Allocator> result( element_count );
+    internal::compute::run_vectors<Allocator>(
             std::array { a.data(), result.data() },
             element_count,
+            result.size(),
             [b]( auto& ctx ) {
                 auto a_i = ctx.load( 0 );
                 auto result_i = a_i + b;
@@ -636,15 +3352,19 @@ add( std::vector<CalcType>& a, const CalcType& b ) {
     return result;
 }
 
-template<class CalcType>
+template<class CalcType,
+         class Allocator,
+         class AllocatorB,
+         class AllocatorResult>
 void
-add_in( std::vector<CalcType>& a,
-        std::vector<CalcType>& b,
-        std::vector<CalcType>& result ) {
+add_in( std::vector<CalcType, Allocator>&       a,
+        std::vector<CalcType, AllocatorB>&      b,
+        std::vector<CalcType, AllocatorResult>& result ) {
     const size_t element_count = helper::element_count_min( a, b, result );
-    internal::compute::run(
+    internal::compute::run_vectors<Allocator, AllocatorB, AllocatorResult>(
             std::array { a.data(), b.data(), result.data() },
             element_count,
+            result.size(),
             []( auto& ctx ) {
                 auto a_i = ctx.load( 0 );
                 auto b_i = ctx.load( 1 );
@@ -653,15 +3373,16 @@ add_in( std::vector<CalcType>& a,
             } );
 }
 
-template<class CalcType>
+template<class CalcType, class Allocator, class AllocatorResult>
 void
-add_in( std::vector<CalcType>& a,
-        const CalcType&        b,
-        std::vector<CalcType>& result ) {
+add_in( std::vector<CalcType, Allocator>&       a,
+        const CalcType&                         b,
+        std::vector<CalcType, AllocatorResult>& result ) {
     const size_t element_count = helper::element_count_min( a, result );
-    internal::compute::run(
+    internal::compute::run_vectors<Allocator, AllocatorResult>(
             std::array { a.data(), result.data() },
             element_count,
+            result.size(),
             [&]( auto& ctx ) {
                 auto a_i = ctx.load( 0 );
                 auto result_i = a_i + b;
@@ -669,14 +3390,16 @@ add_in( std::vector<CalcType>& a,
             } );
 }
 
-template<class CalcType>
-std::vector<CalcType>
-sub( std::vector<CalcType>& a, std::vector<CalcType>& b ) {
-    const size_t          element_count = helper::element_count_min( a, b );
-    std::vector<CalcType> result( element_count );
-    internal::compute::run(
+template<class CalcType, class Allocator, class AllocatorB>
+std::vector<CalcType, Allocator>
+sub( std::vector<CalcType, Allocator>&  a,
+     std::vector<CalcType, AllocatorB>& b ) {
+    const size_t element_count = helper::element_count_min( a, b );
+    std::vector<CalcType, Allocator> result( element_count );
+    internal::compute::run_vectors<Allocator, AllocatorB>(
             std::array { a.data(), b.data(), result.data() },
             element_count,
+            result.size(),
             []( auto& ctx ) {
                 auto a_i = ctx.load( 0 );
                 auto b_i = ctx.load( 1 );
@@ -686,14 +3409,15 @@ sub( std::vector<CalcType>& a, std::vector<CalcType>& b ) {
     return result;
 }
 
-template<class CalcType>
-std::vector<CalcType>
-sub( std::vector<CalcType>& a, const CalcType& b ) {
-    const size_t          element_count = helper::element_count_min( a );
-    std::vector<CalcType> result( element_count );
-    internal::compute::run(
+template<class CalcType, class Allocator>
+std::vector<CalcType, Allocator>
+sub( std::vector<CalcType, Allocator>& a, const CalcType& b ) {
+    const size_t element_count = helper::element_count_min( a );
+    std::vector<CalcType, Allocator> result( element_count );
+    internal::compute::run_vectors<Allocator>(
             std::array { a.data(), result.data() },
             element_count,
+            result.size(),
             [b]( auto& ctx ) {
                 auto a_i = ctx.load( 0 );
                 auto result_i = a_i - b;
@@ -702,15 +3426,19 @@ sub( std::vector<CalcType>& a, const CalcType& b ) {
     return result;
 }
 
-template<class CalcType>
+template<class CalcType,
+         class Allocator,
+         class AllocatorB,
+         class AllocatorResult>
 void
-sub_in( std::vector<CalcType>& a,
-        std::vector<CalcType>& b,
-        std::vector<CalcType>& result ) {
+sub_in( std::vector<CalcType, Allocator>&       a,
+        std::vector<CalcType, AllocatorB>&      b,
+        std::vector<CalcType, AllocatorResult>& result ) {
     const size_t element_count = helper::element_count_min( a, b, result );
-    internal::compute::run(
+    internal::compute::run_vectors<Allocator, AllocatorB, AllocatorResult>(
             std::array { a.data(), b.data(), result.data() },
             element_count,
+            result.size(),
             []( auto& ctx ) {
                 auto a_i = ctx.load( 0 );
                 auto b_i = ctx.load( 1 );
@@ -719,15 +3447,16 @@ sub_in( std::vector<CalcType>& a,
             } );
 }
 
-template<class CalcType>
+template<class CalcType, class Allocator, class AllocatorResult>
 void
-sub_in( std::vector<CalcType>& a,
-        const CalcType&        b,
-        std::vector<CalcType>& result ) {
+sub_in( std::vector<CalcType, Allocator>&       a,
+        const CalcType&                         b,
+        std::vector<CalcType, AllocatorResult>& result ) {
     const size_t element_count = helper::element_count_min( a, result );
-    internal::compute::run(
+    internal::compute::run_vectors<Allocator, AllocatorResult>(
             std::array { a.data(), result.data() },
             element_count,
+            result.size(),
             [&]( auto& ctx ) {
                 auto a_i = ctx.load( 0 );
                 auto result_i = a_i - b;
@@ -735,14 +3464,16 @@ sub_in( std::vector<CalcType>& a,
             } );
 }
 
-template<class CalcType>
-std::vector<CalcType>
-mul( std::vector<CalcType>& a, std::vector<CalcType>& b ) {
-    const size_t          element_count = helper::element_count_min( a, b );
-    std::vector<CalcType> result( element_count );
-    internal::compute::run(
+template<class CalcType, class Allocator, class AllocatorB>
+std::vector<CalcType, Allocator>
+mul( std::vector<CalcType, Allocator>&  a,
+     std::vector<CalcType, AllocatorB>& b ) {
+    const size_t element_count = helper::element_count_min( a, b );
+    std::vector<CalcType, Allocator> result( element_count );
+    internal::compute::run_vectors<Allocator, AllocatorB>(
             std::array { a.data(), b.data(), result.data() },
             element_count,
+            result.size(),
             []( auto& ctx ) {
                 auto a_i = ctx.load( 0 );
                 auto b_i = ctx.load( 1 );
@@ -752,14 +3483,15 @@ mul( std::vector<CalcType>& a, std::vector<CalcType>& b ) {
     return result;
 }
 
-template<class CalcType>
-std::vector<CalcType>
-mul( std::vector<CalcType>& a, const CalcType& b ) {
-    const size_t          element_count = helper::element_count_min( a );
-    std::vector<CalcType> result( element_count );
-    internal::compute::run(
+template<class CalcType, class Allocator>
+std::vector<CalcType, Allocator>
+mul( std::vector<CalcType, Allocator>& a, const CalcType& b ) {
+    const size_t element_count = helper::element_count_min( a );
+    std::vector<CalcType, Allocator> result( element_count );
+    internal::compute::run_vectors<Allocator>(
             std::array { a.data(), result.data() },
             element_count,
+            result.size(),
             [b]( auto& ctx ) {
                 auto a_i = ctx.load( 0 );
                 auto result_i = a_i * b;
@@ -768,15 +3500,19 @@ mul( std::vector<CalcType>& a, const CalcType& b ) {
     return result;
 }
 
-template<class CalcType>
+template<class CalcType,
+         class Allocator,
+         class AllocatorB,
+         class AllocatorResult>
 void
-mul_in( std::vector<CalcType>& a,
-        std::vector<CalcType>& b,
-        std::vector<CalcType>& result ) {
+mul_in( std::vector<CalcType, Allocator>&       a,
+        std::vector<CalcType, AllocatorB>&      b,
+        std::vector<CalcType, AllocatorResult>& result ) {
     const size_t element_count = helper::element_count_min( a, b, result );
-    internal::compute::run(
+    internal::compute::run_vectors<Allocator, AllocatorB, AllocatorResult>(
             std::array { a.data(), b.data(), result.data() },
             element_count,
+            result.size(),
             []( auto& ctx ) {
                 auto a_i = ctx.load( 0 );
                 auto b_i = ctx.load( 1 );
@@ -785,15 +3521,16 @@ mul_in( std::vector<CalcType>& a,
             } );
 }
 
-template<class CalcType>
+template<class CalcType, class Allocator, class AllocatorResult>
 void
-mul_in( std::vector<CalcType>& a,
-        const CalcType&        b,
-        std::vector<CalcType>& result ) {
+mul_in( std::vector<CalcType, Allocator>&       a,
+        const CalcType&                         b,
+        std::vector<CalcType, AllocatorResult>& result ) {
     const size_t element_count = helper::element_count_min( a, result );
-    internal::compute::run(
+    internal::compute::run_vectors<Allocator, AllocatorResult>(
             std::array { a.data(), result.data() },
             element_count,
+            result.size(),
             [&]( auto& ctx ) {
                 auto a_i = ctx.load( 0 );
                 auto result_i = a_i * b;
@@ -801,14 +3538,16 @@ mul_in( std::vector<CalcType>& a,
             } );
 }
 
-template<class CalcType>
-std::vector<CalcType>
-div( std::vector<CalcType>& a, std::vector<CalcType>& b ) {
-    const size_t          element_count = helper::element_count_min( a, b );
-    std::vector<CalcType> result( element_count );
-    internal::compute::run(
+template<class CalcType, class Allocator, class AllocatorB>
+std::vector<CalcType, Allocator>
+div( std::vector<CalcType, Allocator>&  a,
+     std::vector<CalcType, AllocatorB>& b ) {
+    const size_t element_count = helper::element_count_min( a, b );
+    std::vector<CalcType, Allocator> result( element_count );
+    internal::compute::run_vectors<Allocator, AllocatorB>(
             std::array { a.data(), b.data(), result.data() },
             element_count,
+            result.size(),
             []( auto& ctx ) {
                 auto a_i = ctx.load( 0 );
                 auto b_i = ctx.load( 1 );
@@ -818,31 +3557,36 @@ div( std::vector<CalcType>& a, std::vector<CalcType>& b ) {
     return result;
 }
 
-template<class CalcType>
-std::vector<CalcType>
-div( std::vector<CalcType>& a, const CalcType& b ) {
-    const size_t          element_count = helper::element_count_min( a );
-    std::vector<CalcType> result( element_count );
-    internal::compute::run(
+template<class CalcType, class Allocator>
+std::vector<CalcType, Allocator>
+div( std::vector<CalcType, Allocator>& a, const CalcType& b ) {
+    const size_t element_count = helper::element_count_min( a );
+    std::vector<CalcType, Allocator> result( element_count );
+    internal::compute::run_vectors<Allocator>(
             std::array { a.data(), result.data() },
             element_count,
-            [b]( auto& ctx ) {
+            result.size(),
+            [d = divisor<CalcType>( b )]( auto& ctx ) {
                 auto a_i = ctx.load( 0 );
-                auto result_i = a_i / b;
+                auto result_i = a_i / d;
                 ctx.store( result_i, 1 );
             } );
     return result;
 }
 
-template<class CalcType>
+template<class CalcType,
+         class Allocator,
+         class AllocatorB,
+         class AllocatorResult>
 void
-div_in( std::vector<CalcType>& a,
-        std::vector<CalcType>& b,
-        std::vector<CalcType>& result ) {
+div_in( std::vector<CalcType, Allocator>&       a,
+        std::vector<CalcType, AllocatorB>&      b,
+        std::vector<CalcType, AllocatorResult>& result ) {
     const size_t element_count = helper::element_count_min( a, b, result );
-    internal::compute::run(
+    internal::compute::run_vectors<Allocator, AllocatorB, AllocatorResult>(
             std::array { a.data(), b.data(), result.data() },
             element_count,
+            result.size(),
             []( auto& ctx ) {
                 auto a_i = ctx.load( 0 );
                 auto b_i = ctx.load( 1 );
@@ -851,70 +3595,557 @@ div_in( std::vector<CalcType>& a,
             } );
 }
 
-template<class CalcType>
+template<class CalcType, class Allocator, class AllocatorResult>
 void
-div_in( std::vector<CalcType>& a,
-        const CalcType&        b,
-        std::vector<CalcType>& result ) {
+div_in( std::vector<CalcType, Allocator>&       a,
+        const CalcType&                         b,
+        std::vector<CalcType, AllocatorResult>& result ) {
     const size_t element_count = helper::element_count_min( a, result );
-    internal::compute::run(
+
+    const divisor<CalcType> d( b );
+    internal::compute::run_vectors<Allocator, AllocatorResult>(
             std::array { a.data(), result.data() },
             element_count,
+            result.size(),
             [&]( auto& ctx ) {
                 auto a_i = ctx.load( 0 );
-                auto result_i = a_i / b;
+                auto result_i = a_i / d;
                 ctx.store( result_i, 1 );
             } );
 }
 
-}    // namespace vecex
+// pointer + element_count versions for memory that isn't a std::vector (mmap,
+// arenas, buffers of other libraries). the inputs are only read
+
+template<class CalcType>
+void
+add_in( const CalcType* a,
+        const CalcType* b,
+        CalcType*       result,
+        const size_t    element_count ) {
+    internal::compute::run( std::array { const_cast<CalcType*>( a ),
+                                         const_cast<CalcType*>( b ),
+                                         result },
+                            element_count,
+                            []( auto& ctx ) {
+                                auto a_i = ctx.load( 0 );
+                                auto b_i = ctx.load( 1 );
+                                auto result_i = a_i + b_i;
+                                ctx.store( result_i, 2 );
+                            } );
+}
+
+template<class CalcType>
+void
+add_in( const CalcType* a,
+        const CalcType& b,
+        CalcType*       result,
+        const size_t    element_count ) {
+    internal::compute::run(
+            std::array { const_cast<CalcType*>( a ), result },
+            element_count,
+            [&]( auto& ctx ) {
+                auto a_i = ctx.load( 0 );
+                auto result_i = a_i + b;
+                ctx.store( result_i, 1 );
+            } );
+}
+
+template<class CalcType>
+default_init_vector<CalcType>
+add( const CalcType* a, const CalcType* b, const size_t element_count ) {
+    default_init_vector<CalcType> result( element_count );
+    add_in( a, b, result.data(), element_count );
+    return result;
+}
+
+template<class CalcType>
+default_init_vector<CalcType>
+add( const CalcType* a, const CalcType& b, const size_t element_count ) {
+    default_init_vector<CalcType> result( element_count );
+    add_in( a, b, result.data(), element_count );
+    return result;
+}
+
+template<class CalcType>
+void
+sub_in( const CalcType* a,
+        const CalcType* b,
+        CalcType*       result,
+        const size_t    element_count ) {
+    internal::compute::run( std::array { const_cast<CalcType*>( a ),
+                                         const_cast<CalcType*>( b ),
+                                         result },
+                            element_count,
+                            []( auto& ctx ) {
+                                auto a_i = ctx.load( 0 );
+                                auto b_i = ctx.load( 1 );
+                                auto result_i = a_i - b_i;
+                                ctx.store( result_i, 2 );
+                            } );
+}
+
+template<class CalcType>
+void
+sub_in( const CalcType* a,
+        const CalcType& b,
+        CalcType*       result,
+        const size_t    element_count ) {
+    internal::compute::run(
+            std::array { const_cast<CalcType*>( a ), result },
+            element_count,
+            [&]( auto& ctx ) {
+                auto a_i = ctx.load( 0 );
+                auto result_i = a_i - b;
+                ctx.store( result_i, 1 );
+            } );
+}
+
+template<class CalcType>
+default_init_vector<CalcType>
+sub( const CalcType* a, const CalcType* b, const size_t element_count ) {
+    default_init_vector<CalcType> result( element_count );
+    sub_in( a, b, result.data(), element_count );
+    return result;
+}
+
+template<class CalcType>
+default_init_vector<CalcType>
+sub( const CalcType* a, const CalcType& b, const size_t element_count ) {
+    default_init_vector<CalcType> result( element_count );
+    sub_in( a, b, result.data(), element_count );
+    return result;
+}
+
+template<class CalcType>
+void
+mul_in( const CalcType* a,
+        const CalcType* b,
+        CalcType*       result,
+        const size_t    element_count ) {
+    internal::compute::run( std::array { const_cast<CalcType*>( a ),
+                                         const_cast<CalcType*>( b ),
+                                         result },
+                            element_count,
+                            []( auto& ctx ) {
+                                auto a_i = ctx.load( 0 );
+                                auto b_i = ctx.load( 1 );
+                                auto result_i = a_i * b_i;
+                                ctx.store( result_i, 2 );
+                            } );
+}
 
-#ifdef VECEX_OVERRIDE
 template<class CalcType>
-std::vector<CalcType>
-operator+( std::vector<CalcType>& lhs, std::vector<CalcType>& rhs ) {
-    return vecex::add( lhs, rhs );
+void
+mul_in( const CalcType* a,
+        const CalcType& b,
+        CalcType*       result,
+        const size_t    element_count ) {
+    internal::compute::run(
+            std::array { const_cast<CalcType*>( a ), result },
+            element_count,
+            [&]( auto& ctx ) {
+                auto a_i = ctx.load( 0 );
+                auto result_i = a_i * b;
+                ctx.store( result_i, 1 );
+            } );
 }
 
 template<class CalcType>
-std::vector<CalcType>
-operator+( std::vector<CalcType>& lhs, const CalcType& rhs ) {
-    return vecex::add( lhs, rhs );
+default_init_vector<CalcType>
+mul( const CalcType* a, const CalcType* b, const size_t element_count ) {
+    default_init_vector<CalcType> result( element_count );
+    mul_in( a, b, result.data(), element_count );
+    return result;
 }
 
 template<class CalcType>
-std::vector<CalcType>
-operator-( std::vector<CalcType>& lhs, std::vector<CalcType>& rhs ) {
-    return vecex::sub( lhs, rhs );
+default_init_vector<CalcType>
+mul( const CalcType* a, const CalcType& b, const size_t element_count ) {
+    default_init_vector<CalcType> result( element_count );
+    mul_in( a, b, result.data(), element_count );
+    return result;
 }
 
 template<class CalcType>
-std::vector<CalcType>
-operator-( std::vector<CalcType>& lhs, const CalcType& rhs ) {
-    return vecex::sub( lhs, rhs );
+void
+div_in( const CalcType* a,
+        const CalcType* b,
+        CalcType*       result,
+        const size_t    element_count ) {
+    internal::compute::run( std::array { const_cast<CalcType*>( a ),
+                                         const_cast<CalcType*>( b ),
+                                         result },
+                            element_count,
+                            []( auto& ctx ) {
+                                auto a_i = ctx.load( 0 );
+                                auto b_i = ctx.load( 1 );
+                                auto result_i = a_i / b_i;
+                                ctx.store( result_i, 2 );
+                            } );
 }
 
 template<class CalcType>
-std::vector<CalcType>
-operator*( std::vector<CalcType>& lhs, std::vector<CalcType>& rhs ) {
-    return vecex::mul( lhs, rhs );
+void
+div_in( const CalcType* a,
+        const CalcType& b,
+        CalcType*       result,
+        const size_t    element_count ) {
+    const divisor<CalcType> d( b );
+    internal::compute::run(
+            std::array { const_cast<CalcType*>( a ), result },
+            element_count,
+            [&]( auto& ctx ) {
+                auto a_i = ctx.load( 0 );
+                auto result_i = a_i / d;
+                ctx.store( result_i, 1 );
+            } );
 }
 
 template<class CalcType>
-std::vector<CalcType>
-operator*( std::vector<CalcType>& lhs, const CalcType& rhs ) {
-    return vecex::mul( lhs, rhs );
+default_init_vector<CalcType>
+div( const CalcType* a, const CalcType* b, const size_t element_count ) {
+    default_init_vector<CalcType> result( element_count );
+    div_in( a, b, result.data(), element_count );
+    return result;
 }
 
 template<class CalcType>
-std::vector<CalcType>
-operator/( std::vector<CalcType>& lhs, std::vector<CalcType>& rhs ) {
-    return vecex::div( lhs, rhs );
+default_init_vector<CalcType>
+div( const CalcType* a, const CalcType& b, const size_t element_count ) {
+    default_init_vector<CalcType> result( element_count );
+    div_in( a, b, result.data(), element_count );
+    return result;
 }
 
+//
+// lazy expressions of the VECEX_OVERRIDE operators. a + b * c only builds a
+// tree of nodes. converting the tree to a std::vector (or vecex::assign)
+// evaluates all of it in a single compute pass without temporaries
+//
+namespace internal {
+namespace expression {
+
+struct Add {
+    template<class V>
+    static inline V
+    apply( const V& a, const V& b ) {
+        return a + b;
+    }
+};
+struct Sub {
+    template<class V>
+    static inline V
+    apply( const V& a, const V& b ) {
+        return a - b;
+    }
+};
+struct Mul {
+    template<class V>
+    static inline V
+    apply( const V& a, const V& b ) {
+        return a * b;
+    }
+};
+struct Div {
+    // b is a Value or a vecex::divisor
+    template<class V, class B>
+    static inline V
+    apply( const V& a, const B& b ) {
+        return a / b;
+    }
+};
+
+template<class Allocator, class Node>
+std::vector<typename Node::calc_type, Allocator>
+evaluate( const Node& node );
+
+// a std::vector inside of an expression, one data set of the compute pass
+template<class CalcType>
+struct Leaf {
+    typedef CalcType    calc_type;
+    static const size_t leaf_count = 1;
+
+    const CalcType* data;
+    size_t          element_count;
+
+    template<size_t index, class Context>
+    inline auto
+    eval( Context& ctx ) const {
+        return ctx.load( index );
+    }
+
+    template<size_t N>
+    inline void
+    collect( std::array<CalcType*, N>& data_sets, const size_t index ) const {
+        data_sets[index] = (CalcType*)this->data;
+    }
+
+    inline size_t
+    size() const {
+        return this->element_count;
+    }
+};
+
+template<class CalcType>
+struct Scalar {
+    typedef CalcType    calc_type;
+    static const size_t leaf_count = 0;
+
+    CalcType value;
+
+    template<size_t index, class Context>
+    inline auto
+    eval( Context& ) const {
+        return Context::_Value::from_number( this->value );
+    }
+
+    template<size_t N>
+    inline void
+    collect( std::array<CalcType*, N>&, const size_t ) const {}
+
+    inline size_t
+    size() const {
+        return std::numeric_limits<size_t>::max();
+    }
+};
+
+// the number on the right of a division. the vecex::divisor is built once
+// with the expression, not for every vector
 template<class CalcType>
-std::vector<CalcType>
-operator/( std::vector<CalcType>& lhs, const CalcType& rhs ) {
-    return vecex::div( lhs, rhs );
+struct ScalarDivisor {
+    typedef CalcType    calc_type;
+    static const size_t leaf_count = 0;
+
+    divisor<CalcType> value;
+
+    template<size_t index, class Context>
+    inline const divisor<CalcType>&
+    eval( Context& ) const {
+        return this->value;
+    }
+
+    template<size_t N>
+    inline void
+    collect( std::array<CalcType*, N>&, const size_t ) const {}
+
+    inline size_t
+    size() const {
+        return std::numeric_limits<size_t>::max();
+    }
+};
+
+template<class Op, class Left, class Right>
+struct Binary {
+    typedef typename Left::calc_type calc_type;
+    static const size_t leaf_count = Left::leaf_count + Right::leaf_count;
+
+    Left  left;
+    Right right;
+
+    template<size_t index, class Context>
+    inline auto
+    eval( Context& ctx ) const {
+        return Op::apply(
+                this->left.template eval<index>( ctx ),
+                this->right.template eval<index + Left::leaf_count>( ctx ) );
+    }
+
+    template<size_t N>
+    inline void
+    collect( std::array<calc_type*, N>& data_sets,
+             const size_t               index ) const {
+        this->left.collect( data_sets, index );
+        this->right.collect( data_sets, index + Left::leaf_count );
+    }
+
+    inline size_t
+    size() const {
+        const size_t left_size = this->left.size();
+        const size_t right_size = this->right.size();
+        return left_size < right_size ? left_size : right_size;
+    }
+
+    template<class Allocator>
+    operator std::vector<calc_type, Allocator>() const {
+        return evaluate<Allocator>( *this );
+    }
+};
+
+template<class T>
+struct is_node : std::false_type {};
+template<class Op, class Left, class Right>
+struct is_node<Binary<Op, Left, Right>> : std::true_type {};
+
+template<class T>
+struct is_vector : std::false_type {};
+template<class CalcType, class Allocator>
+struct is_vector<std::vector<CalcType, Allocator>> :
+        std::is_arithmetic<CalcType> {};
+
+// element type of a vector or a node, void for everything else
+template<class T, class = void>
+struct calc_type_of {
+    typedef void type;
+};
+template<class T>
+struct calc_type_of<T, std::enable_if_t<is_vector<T>::value>> {
+    typedef typename T::value_type type;
+};
+template<class T>
+struct calc_type_of<T, std::enable_if_t<is_node<T>::value>> {
+    typedef typename T::calc_type type;
+};
+
+// true if From converts to To without narrowing ( To { from } compiles )
+template<class From, class To, class = void>
+struct is_non_narrowing : std::false_type {};
+template<class From, class To>
+struct is_non_narrowing<From,
+                   To,
+                   std::void_t<decltype( To { std::declval<From>() } )>>
+        : std::true_type {};
+
+// vector / node with vector / node / number or number with vector / node,
+// both sides with the same element type. a number has to fit the element
+// type, std::vector<int> + 2.5 doesn't compile
+template<class Left, class Right>
+struct is_operation {
+    typedef typename calc_type_of<Left>::type  left_type;
+    typedef typename calc_type_of<Right>::type right_type;
+
+    static const bool value
+            = ( !std::is_void<left_type>::value
+                && ( std::is_same<left_type, right_type>::value
+                     || ( std::is_arithmetic<Right>::value
+                          && is_non_narrowing<Right, left_type>::value ) ) )
+              || ( std::is_arithmetic<Left>::value
+                   && !std::is_void<right_type>::value
+                   && is_non_narrowing<Left, right_type>::value );
+};
+
+template<class Left, class Right>
+using enable_t = std::enable_if_t<is_operation<Left, Right>::value>;
+
+template<class CalcType, class T>
+inline auto
+to_node( const T& value ) {
+    if constexpr ( is_vector<T>::value ) {
+        return Leaf<CalcType> { value.data(), value.size() };
+    } else if constexpr ( is_node<T>::value ) {
+        return value;
+    } else {
+        return Scalar<CalcType> { value };
+    }
+}
+
+template<class Op, class Left, class Right>
+inline auto
+make( const Left& lhs, const Right& rhs ) {
+    typedef typename std::conditional_t<
+            std::is_arithmetic<Left>::value,
+            calc_type_of<Right>,
+            calc_type_of<Left>>::type calc_type;
+
+    auto left = to_node<calc_type>( lhs );
+    if constexpr ( std::is_same<Op, Div>::value
+                   && std::is_arithmetic<Right>::value ) {
+        ScalarDivisor<calc_type> right { divisor<calc_type>( rhs ) };
+        return Binary<Op, decltype( left ), decltype( right )> { left,
+                                                                 right };
+    } else {
+        auto right = to_node<calc_type>( rhs );
+        return Binary<Op, decltype( left ), decltype( right )> { left,
+                                                                 right };
+    }
+}
+
+template<class Node>
+inline void
+evaluate_in( const Node&               node,
+             typename Node::calc_type* result,
+             const size_t              element_count ) {
+    typedef typename Node::calc_type CalcType;
+
+    std::array<CalcType*, Node::leaf_count + 1> data_sets;
+    node.collect( data_sets, 0 );
+    data_sets[Node::leaf_count] = result;
+
+    compute::run( data_sets, element_count, [node]( auto& ctx ) {
+        auto result_i = node.template eval<0>( ctx );
+        ctx.store( result_i, Node::leaf_count );
+    } );
+}
+
+template<class Allocator, class Node>
+std::vector<typename Node::calc_type, Allocator>
+evaluate( const Node& node ) {
+    std::vector<typename Node::calc_type, Allocator> result( node.size() );
+    evaluate_in( node, result.data(), result.size() );
+    return result;
+}
+
+};    // namespace expression
+};    // namespace internal
+
+// evaluates an expression of the VECEX_OVERRIDE operators into the storage of
+// result. other than result = a + b no new std::vector is allocated if
+// result is already big enough
+template<class CalcType, class Allocator, class Node>
+void
+assign( std::vector<CalcType, Allocator>& result, const Node& node ) {
+    static_assert( internal::expression::is_node<Node>::value
+                           || internal::expression::is_vector<Node>::value,
+                   "vecex::assign needs an expression or a std::vector" );
+    if constexpr ( internal::expression::is_vector<Node>::value ) {
+        result.assign( node.begin(), node.end() );
+    } else {
+        result.resize( node.size() );
+        internal::expression::evaluate_in(
+                node, result.data(), result.size() );
+    }
+}
+
+#ifdef VECEX_NAMESPACE
+}    // namespace VECEX_NAMESPACE
+#endif
+
+}    // namespace vecex
+
+#ifdef VECEX_OVERRIDE
+template<class Left,
+         class Right,
+         class = vecex::internal::expression::enable_t<Left, Right>>
+inline auto
+operator+( const Left& lhs, const Right& rhs ) {
+    using namespace vecex::internal::expression;
+    return make<Add>( lhs, rhs );
+}
+
+template<class Left,
+         class Right,
+         class = vecex::internal::expression::enable_t<Left, Right>>
+inline auto
+operator-( const Left& lhs, const Right& rhs ) {
+    using namespace vecex::internal::expression;
+    return make<Sub>( lhs, rhs );
+}
+
+template<class Left,
+         class Right,
+         class = vecex::internal::expression::enable_t<Left, Right>>
+inline auto
+operator*( const Left& lhs, const Right& rhs ) {
+    using namespace vecex::internal::expression;
+    return make<Mul>( lhs, rhs );
+}
+
+template<class Left,
+         class Right,
+         class = vecex::internal::expression::enable_t<Left, Right>>
+inline auto
+operator/( const Left& lhs, const Right& rhs ) {
+    using namespace vecex::internal::expression;
+    return make<Div>( lhs, rhs );
 }
 #endif
@@ -0,0 +1,32 @@
+// instruction set detection of the dispatch. compiled without any -m flags,
+// so it runs on every x86-64 cpu
+
+#include "vectorclass.h"
+#include "vectorclass_ext_dispatch.h"
+
+namespace vecex {
+namespace dispatch {
+
+static isa
+detect() {
+    const int level = instrset_detect();
+    // 10 = AVX512BW/DQ/VL, 8 = AVX2 (see instrset.h). both versions are
+    // compiled with -mfma, which instrset_detect doesn't check
+    const bool fma = hasFMA3();
+    if ( level >= 10 && fma ) {
+        return isa::avx512;
+    }
+    if ( level >= 8 && fma ) {
+        return isa::avx2;
+    }
+    return isa::sse2;
+}
+
+isa
+selected() {
+    static const isa result = detect();
+    return result;
+}
+
+}    // namespace dispatch
+}    // namespace vecex
@@ -0,0 +1,185 @@
+/* ###################################################################
+
+MIT License
+
+Copyright (c) 2023 TRP - Thimo Pischel
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+######################################################################
+
+HOW TO USE:
+
+Runtime instruction set dispatch. vectorclass_ext.h picks the simd sizes at
+compile time, so a binary built for SSE2 never uses AVX2 or AVX-512. The
+dispatch compiles the kernels once per instruction set and picks the best one
+for the running cpu on the first call (instrset_detect() of the vectorclass).
+
+* CMake
+link the target vectorclass_ext_dispatch. it contains the add / sub / mul /
+div kernels for sse2, avx2 and avx512.
+
+* add / sub / mul / div (float, double)
+    vecex::dispatch::add( a.data(), b.data(), result.data(), count );
+
+* own compute kernels
+    1. write the kernel in its own .cpp and name it with VECEX_DISPATCH_NAME:
+
+        #include "vectorclass_ext.h"
+        #include "vectorclass_ext_dispatch.h"
+
+        void VECEX_DISPATCH_NAME( my_kernel )( float* a, size_t count ) {
+            vecex::compute( std::array {a}, count, []( auto& ctx ) {...} );
+        }
+
+    2. compile the .cpp once per instruction set:
+        vecex_add_multi_isa( my_target my_kernel.cpp )
+
+    3. declare the three versions and pick one:
+        void my_kernel_sse2( float*, size_t );
+        void my_kernel_avx2( float*, size_t );
+        void my_kernel_avx512( float*, size_t );
+
+        static auto my_kernel = vecex::dispatch::select(
+            &my_kernel_sse2, &my_kernel_avx2, &my_kernel_avx512 );
+
+    Only the functions named with VECEX_DISPATCH_NAME stay visible, the
+    other symbols of the objects are made local (GNU binutils, see
+    vectorclass_ext_isa_object.cmake). Inline functions of other headers
+    (std::array, std::min, ...) keep one copy per instruction set instead of
+    one avx512 copy for the whole program. The build fails if the sse2
+    objects use avx registers.
+
+###################################################################### */
+
+#pragma once
+
+#include <cstddef>
+
+// name of a kernel in a .cpp compiled by vecex_add_multi_isa:
+// VECEX_DISPATCH_NAME( add ) => add_avx2
+#define VECEX_DISPATCH_CONCAT_( a, b ) a##_##b
+#define VECEX_DISPATCH_CONCAT( a, b ) VECEX_DISPATCH_CONCAT_( a, b )
+#define VECEX_DISPATCH_NAME( name ) VECEX_DISPATCH_CONCAT( name, VECEX_ISA )
+
+namespace vecex {
+namespace dispatch {
+
+enum class isa { sse2, avx2, avx512 };
+
+// the instruction set the dispatch uses. detected once on the first call
+isa
+selected();
+
+template<class Function>
+inline Function
+select( Function sse2, Function avx2, Function avx512 ) {
+    switch ( selected() ) {
+        case isa::avx512:
+            return avx512;
+        case isa::avx2:
+            return avx2;
+        default:
+            return sse2;
+    }
+}
+
+template<class CalcType>
+struct Kernels {
+    typedef void ( *binary )( const CalcType* a,
+                              const CalcType* b,
+                              CalcType*       result,
+                              size_t          element_count );
+    binary add;
+    binary sub;
+    binary mul;
+    binary div;
+};
+
+struct KernelTable {
+    Kernels<float>  f32;
+    Kernels<double> f64;
+};
+
+// one table per instruction set, see vectorclass_ext_dispatch_kernels.cpp
+extern const KernelTable kernel_table_sse2;
+extern const KernelTable kernel_table_avx2;
+extern const KernelTable kernel_table_avx512;
+
+inline const KernelTable&
+table() {
+    static const KernelTable& selected_table = *select(
+            &kernel_table_sse2, &kernel_table_avx2, &kernel_table_avx512 );
+    return selected_table;
+}
+
+template<class CalcType>
+inline const Kernels<CalcType>&
+kernels();
+
+template<>
+inline const Kernels<float>&
+kernels<float>() {
+    return table().f32;
+}
+
+template<>
+inline const Kernels<double>&
+kernels<double>() {
+    return table().f64;
+}
+
+template<class CalcType>
+inline void
+add( const CalcType* a,
+     const CalcType* b,
+     CalcType*       result,
+     size_t          element_count ) {
+    kernels<CalcType>().add( a, b, result, element_count );
+}
+
+template<class CalcType>
+inline void
+sub( const CalcType* a,
+     const CalcType* b,
+     CalcType*       result,
+     size_t          element_count ) {
+    kernels<CalcType>().sub( a, b, result, element_count );
+}
+
+template<class CalcType>
+inline void
+mul( const CalcType* a,
+     const CalcType* b,
+     CalcType*       result,
+     size_t          element_count ) {
+    kernels<CalcType>().mul( a, b, result, element_count );
+}
+
+template<class CalcType>
+inline void
+div( const CalcType* a,
+     const CalcType* b,
+     CalcType*       result,
+     size_t          element_count ) {
+    kernels<CalcType>().div( a, b, result, element_count );
+}
+
+}    // namespace dispatch
+}    // namespace vecex
@@ -0,0 +1,93 @@
+// the kernels of vectorclass_ext_dispatch.h. compiled once per instruction
+// set by vecex_add_multi_isa (CMakeLists.txt), which defines VECEX_ISA,
+// VCL_NAMESPACE and VECEX_NAMESPACE
+
+#include "vectorclass_ext.h"
+#include "vectorclass_ext_dispatch.h"
+
+namespace {
+
+typedef vecex::policy<>::with_tail<vecex::tail_mode::masked> kernel_policy;
+
+template<class CalcType>
+void
+add_kernel( const CalcType* a,
+            const CalcType* b,
+            CalcType*       result,
+            size_t          element_count ) {
+    vecex::compute(
+            std::array { (CalcType*)a, (CalcType*)b, result },
+            element_count,
+            []( auto& ctx ) {
+                auto result_i = ctx.load( 0 ) + ctx.load( 1 );
+                ctx.store( result_i, 2 );
+            },
+            kernel_policy {} );
+}
+
+template<class CalcType>
+void
+sub_kernel( const CalcType* a,
+            const CalcType* b,
+            CalcType*       result,
+            size_t          element_count ) {
+    vecex::compute(
+            std::array { (CalcType*)a, (CalcType*)b, result },
+            element_count,
+            []( auto& ctx ) {
+                auto result_i = ctx.load( 0 ) - ctx.load( 1 );
+                ctx.store( result_i, 2 );
+            },
+            kernel_policy {} );
+}
+
+template<class CalcType>
+void
+mul_kernel( const CalcType* a,
+            const CalcType* b,
+            CalcType*       result,
+            size_t          element_count ) {
+    vecex::compute(
+            std::array { (CalcType*)a, (CalcType*)b, result },
+            element_count,
+            []( auto& ctx ) {
+                auto result_i = ctx.load( 0 ) * ctx.load( 1 );
+                ctx.store( result_i, 2 );
+            },
+            kernel_policy {} );
+}
+
+template<class CalcType>
+void
+div_kernel( const CalcType* a,
+            const CalcType* b,
+            CalcType*       result,
+            size_t          element_count ) {
+    vecex::compute(
+            std::array { (CalcType*)a, (CalcType*)b, result },
+            element_count,
+            []( auto& ctx ) {
+                auto result_i = ctx.load( 0 ) / ctx.load( 1 );
+                ctx.store( result_i, 2 );
+            },
+            kernel_policy {} );
+}
+
+}    // namespace
+
+namespace vecex {
+namespace dispatch {
+
+const KernelTable VECEX_DISPATCH_NAME( kernel_table ) = {
+    { &add_kernel<float>,
+      &sub_kernel<float>,
+      &mul_kernel<float>,
+      &div_kernel<float> },
+    { &add_kernel<double>,
+      &sub_kernel<double>,
+      &mul_kernel<double>,
+      &div_kernel<double> }
+};
+
+}    // namespace dispatch
+}    // namespace vecex
@@ -0,0 +1,66 @@
+# links the objects of one instruction set of vecex_add_multi_isa into
+# OUTPUT and keeps only the symbols that name the instruction set global.
+#
+# inline functions and template instantiations of other headers
+# (std::array<float*, 3>::operator[], std::min<int>, ...) are weak COMDAT
+# symbols with the same name in every instruction set. the linker keeps one
+# copy for the whole program, maybe the avx512 one. they are made local and
+# their COMDAT groups are dropped, so every object keeps its own copy.
+#
+# cmake -DLINKER=ld -DOBJCOPY=objcopy -DNM=nm -DOBJDUMP=objdump -DISA=avx2
+#       -DOUTPUT=out.o -DOBJECTS=a.o;b.o -P vectorclass_ext_isa_object.cmake
+
+foreach(tool LINKER OBJCOPY NM OBJDUMP)
+  if(NOT ${tool})
+    message(FATAL_ERROR "vecex_add_multi_isa: ${tool} not found")
+  endif()
+endforeach()
+
+macro(check_result tool)
+  if(NOT result EQUAL 0)
+    file(REMOVE ${OUTPUT})
+    message(FATAL_ERROR "vecex_add_multi_isa: ${tool} failed: ${result}")
+  endif()
+endmacro()
+
+execute_process(
+  COMMAND ${LINKER} -r -o ${OUTPUT} ${OBJECTS}
+  RESULT_VARIABLE result
+)
+check_result(${LINKER})
+execute_process(
+  COMMAND ${OBJCOPY} --wildcard --keep-global-symbol=*_${ISA}*
+          --remove-section=.group ${OUTPUT}
+  RESULT_VARIABLE result
+)
+check_result(${OBJCOPY})
+
+# every global definition left has to name the instruction set
+execute_process(
+  COMMAND ${NM} --defined-only --extern-only ${OUTPUT}
+  OUTPUT_VARIABLE symbols
+  RESULT_VARIABLE result
+)
+check_result(${NM})
+string(REPLACE "\n" ";" symbols "${symbols}")
+foreach(line ${symbols})
+  if(NOT line MATCHES "_${ISA}")
+    file(REMOVE ${OUTPUT})
+    message(FATAL_ERROR
+      "vecex_add_multi_isa: ${OUTPUT} exports a shared symbol: ${line}")
+  endif()
+endforeach()
+
+# the sse2 version runs on every x86-64 cpu, no avx register may show up
+if(ISA STREQUAL "sse2")
+  execute_process(
+    COMMAND ${OBJDUMP} -d ${OUTPUT}
+    OUTPUT_VARIABLE code
+    RESULT_VARIABLE result
+  )
+  check_result(${OBJDUMP})
+  if(code MATCHES "%[yz]mm|%k[0-7]")
+    file(REMOVE ${OUTPUT})
+    message(FATAL_ERROR "vecex_add_multi_isa: ${OUTPUT} uses avx registers")
+  endif()
+endif()
@@ -0,0 +1,309 @@
+/* ###################################################################
+
+MIT License
+
+Copyright (c) 2023 TRP - Thimo Pischel
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+######################################################################
+
+HOW TO USE:
+
+Compute over raw binary files (an array of numbers without header) mapped
+into memory. POSIX only (mmap / madvise).
+
+-> vecex::mapped_array<T>( path, mode )
+    maps the whole file, size() is the file size / sizeof(T).
+    mode -> vecex::map_mode::read (default) or vecex::map_mode::read_write.
+            writes into a read mapping crash, read_write writes go back to
+            the file (flush() waits for them)
+-> vecex::mapped_array<T>( path, element_count )
+    creates (or truncates) the file with element_count elements and maps it
+    read_write, e.g. for the result of a compute
+
+    errors of open / mmap are thrown as std::system_error. data(), size(),
+    operator[], begin() and end() work like the ones of a std::vector
+
+-> vecex::compute_mapped
+    Arg1 - Arg4 -> same as vecex::compute
+    runs the range in windows of 16 MiB per data set. while a window is
+    computed the next one is requested with madvise(MADV_WILLNEED), so the
+    kernel reads the file ahead of the compute offset. the mappings are
+    MADV_SEQUENTIAL and the pages of a finished window are advised
+    MADV_COLD (Linux 5.4+), under memory pressure they are reclaimed before
+    other pages. the content stays, the hint is fine for any memory.
+    ctx.emit doesn't compile (the windows run as separate ranges like the
+    chunks of compute_parallel), everything else works as with compute.
+
+    vecex::mapped_array<float> a( "a.bin" );
+    vecex::mapped_array<float> b( "b.bin" );
+    vecex::mapped_array<float> result( "result.bin", a.size() );
+    vecex::compute_mapped( std::array {a.data(), b.data(), result.data()},
+        a.size(), []( auto& ctx ) {
+            ctx.store( ctx.load(0) * ctx.load(1), 2 );
+        });
+
+###################################################################### */
+
+#pragma once
+
+#include "vectorclass_ext.h"
+#include <string>
+#include <system_error>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace vecex {
+
+#ifdef VECEX_NAMESPACE
+inline namespace VECEX_NAMESPACE {
+#endif
+
+enum class map_mode { read, read_write };
+
+template<class T>
+class mapped_array {
+  public:
+    typedef T value_type;
+
+    mapped_array( const std::string& path,
+                  const map_mode     mode = map_mode::read ) {
+        const bool writable = mode == map_mode::read_write;
+        const int  fd = open_file( path, writable ? O_RDWR : O_RDONLY );
+        struct stat info;
+        if ( ::fstat( fd, &info ) != 0 ) {
+            close_and_throw( fd, "fstat " + path );
+        }
+        map( fd, (size_t)info.st_size / sizeof( T ), writable, path );
+    }
+
+    mapped_array( const std::string& path, const size_t count ) {
+        const int fd = open_file( path, O_RDWR | O_CREAT | O_TRUNC );
+        if ( ::ftruncate( fd, (off_t)( count * sizeof( T ) ) ) != 0 ) {
+            close_and_throw( fd, "ftruncate " + path );
+        }
+        map( fd, count, true, path );
+    }
+
+    mapped_array( const mapped_array& ) = delete;
+    mapped_array&
+    operator=( const mapped_array& ) = delete;
+
+    mapped_array( mapped_array&& other ) noexcept :
+            pointer( other.pointer ), element_count( other.element_count ) {
+        other.pointer = nullptr;
+        other.element_count = 0;
+    }
+
+    mapped_array&
+    operator=( mapped_array&& other ) noexcept {
+        std::swap( this->pointer, other.pointer );
+        std::swap( this->element_count, other.element_count );
+        return *this;
+    }
+
+    ~mapped_array() {
+        if ( this->pointer != nullptr ) {
+            ::munmap( this->pointer, bytes() );
+        }
+    }
+
+    T*
+    data() {
+        return this->pointer;
+    }
+    const T*
+    data() const {
+        return this->pointer;
+    }
+    size_t
+    size() const {
+        return this->element_count;
+    }
+
+    T&
+    operator[]( const size_t index ) {
+        return this->pointer[index];
+    }
+    const T&
+    operator[]( const size_t index ) const {
+        return this->pointer[index];
+    }
+
+    T*
+    begin() {
+        return this->pointer;
+    }
+    T*
+    end() {
+        return this->pointer + this->element_count;
+    }
+    const T*
+    begin() const {
+        return this->pointer;
+    }
+    const T*
+    end() const {
+        return this->pointer + this->element_count;
+    }
+
+    // blocks until the written pages are in the file
+    void
+    flush() {
+        if ( this->pointer != nullptr
+             && ::msync( this->pointer, bytes(), MS_SYNC ) != 0 ) {
+            throw std::system_error( errno, std::generic_category(), "msync" );
+        }
+    }
+
+  private:
+    T*     pointer = nullptr;
+    size_t element_count = 0;
+
+    size_t
+    bytes() const {
+        return this->element_count * sizeof( T );
+    }
+
+    static int
+    open_file( const std::string& path, const int flags ) {
+        const int fd = ::open( path.c_str(), flags, 0644 );
+        if ( fd < 0 ) {
+            throw std::system_error(
+                    errno, std::generic_category(), "open " + path );
+        }
+        return fd;
+    }
+
+    [[noreturn]] static void
+    close_and_throw( const int fd, const std::string& what ) {
+        const int error = errno;
+        ::close( fd );
+        throw std::system_error( error, std::generic_category(), what );
+    }
+
+    // the mapping keeps the file open, the descriptor isn't needed anymore
+    void
+    map( const int          fd,
+         const size_t       count,
+         const bool         writable,
+         const std::string& path ) {
+        this->element_count = count;
+        if ( count == 0 ) {
+            ::close( fd );
+            return;
+        }
+        void* ptr = ::mmap( nullptr,
+                            bytes(),
+                            writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                            MAP_SHARED,
+                            fd,
+                            0 );
+        if ( ptr == MAP_FAILED ) {
+            close_and_throw( fd, "mmap " + path );
+        }
+        ::close( fd );
+        ::madvise( ptr, bytes(), MADV_SEQUENTIAL );
+        this->pointer = (T*)ptr;
+    }
+};
+
+namespace internal {
+namespace mapped {
+
+// bytes of every data set per window of compute_mapped
+static const size_t window_bytes = 1 << 24;
+
+// madvise needs a page aligned start. only a hint, errors (e.g. for memory
+// that isn't mapped from a file) are ignored
+template<class CalcType>
+inline void
+will_need( CalcType* data, const size_t begin, const size_t end ) {
+    const size_t page = (size_t)::sysconf( _SC_PAGESIZE );
+    const size_t first = (size_t)( data + begin ) / page * page;
+    const size_t last = (size_t)( data + end );
+    if ( last > first ) {
+        ::madvise( (void*)first, last - first, MADV_WILLNEED );
+    }
+}
+
+// the whole pages of a finished window, the next window may still use the
+// last page. MADV_COLD only deactivates them, other than MADV_DONTNEED it
+// doesn't zero anonymous or private memory
+template<class CalcType>
+inline void
+cold( CalcType* data, const size_t begin, const size_t end ) {
+#ifdef MADV_COLD
+    const size_t page = (size_t)::sysconf( _SC_PAGESIZE );
+    const size_t first = ( (size_t)( data + begin ) + page - 1 ) / page * page;
+    const size_t last = (size_t)( data + end ) / page * page;
+    if ( last > first ) {
+        ::madvise( (void*)first, last - first, MADV_COLD );
+    }
+#else
+    (void)data;
+    (void)begin;
+    (void)end;
+#endif
+}
+
+}    // namespace mapped
+}    // namespace internal
+
+template<class CalcType,
+         size_t external_size,
+         class Function,
+         class Policy = policy<>>
+void
+compute_mapped( std::array<CalcType*, external_size> data_sets,
+                const size_t                         element_count,
+                Function                             func,
+                Policy = {} ) {
+    // a multiple of every simd size, only the last window has a tail
+    const size_t WINDOW = internal::mapped::window_bytes / sizeof( CalcType );
+
+    const size_t first_end = WINDOW < element_count ? WINDOW : element_count;
+    for ( CalcType* data : data_sets ) {
+        internal::mapped::will_need( data, 0, first_end );
+    }
+    for ( size_t begin = 0; begin < element_count; begin += WINDOW ) {
+        const size_t end = begin + WINDOW < element_count ? begin + WINDOW
+                                                          : element_count;
+        const size_t next_end
+                = end + WINDOW < element_count ? end + WINDOW : element_count;
+        for ( CalcType* data : data_sets ) {
+            internal::mapped::will_need( data, end, next_end );
+        }
+        internal::compute::run_range<Policy>(
+                data_sets, begin, end, element_count, func );
+        for ( CalcType* data : data_sets ) {
+            internal::mapped::cold( data, begin, end );
+        }
+    }
+}
+
+#ifdef VECEX_NAMESPACE
+}
+#endif
+
+}    // namespace vecex
@@ -0,0 +1,338 @@
+/* ###################################################################
+
+MIT License
+
+Copyright (c) 2023 TRP - Thimo Pischel
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+######################################################################
+
+HOW TO USE:
+
+Compute over data that doesn't fit into memory. The data sets are read from
+inputs and written to outputs in chunks, only two chunks per data set are in
+memory at once.
+
+-> vecex::compute_stream<T>
+    Arg1 -> std::tuple with one input or output per data set, the position
+            is the index for ctx.load / ctx.store
+    Arg2 -> lambda, the same one as for vecex::compute
+    Arg3 -> chunk_elements, optional. rounded up to a multiple of 64 bytes,
+            default 1 MiB per data set
+    Arg4 -> policy, optional. same as compute
+    return -> the count of computed elements. the smallest input decides,
+              the compute stops at the end of the first one
+
+    While the lambda computes a chunk, the other one is written to the
+    outputs and filled with the next chunk of the inputs on a thread of the
+    compute_parallel pool (double buffering). Exceptions of the lambda,
+    the inputs and the outputs are rethrown once both are done. Every chunk
+    is a compute of its own: ctx.load( index, element_offset ) clamps at the
+    chunk edges and ctx.emit doesn't compile.
+
+-> inputs, fill the buffer and return the filled element count, less than
+   count only at the end
+    vecex::stream::from_istream( std::istream& )
+    vecex::stream::from_fd( int fd )                        (POSIX)
+    vecex::stream::input( []( T* buffer, size_t count ) { ... return n; } )
+
+-> outputs, get every computed chunk
+    vecex::stream::to_ostream( std::ostream& )
+    vecex::stream::to_fd( int fd )                          (POSIX)
+    vecex::stream::output( []( const T* buffer, size_t count ) { ... } )
+
+    read and write errors of the stream and fd helpers throw
+    (std::ios_base::failure / std::system_error), interrupted calls repeat
+
+    std::ifstream a( "a.bin", std::ios::binary );
+    std::ofstream result( "result.bin", std::ios::binary );
+    vecex::compute_stream<float>(
+        std::tuple { vecex::stream::from_istream( a ),
+                     vecex::stream::to_ostream( result ) },
+        []( auto& ctx ) {
+            ctx.store( ctx.load(0) * 2, 1 );
+        });
+
+###################################################################### */
+
+#pragma once
+
+#include "vectorclass_ext.h"
+#include <istream>
+#include <ostream>
+#include <system_error>
+#if defined( __unix__ ) || defined( __APPLE__ )
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+namespace vecex {
+
+#ifdef VECEX_NAMESPACE
+inline namespace VECEX_NAMESPACE {
+#endif
+
+namespace stream {
+
+// default size of a chunk per data set
+static const size_t default_chunk_bytes = 1 << 20;
+
+template<class Function>
+struct input_set {
+    Function function;
+};
+
+template<class Function>
+struct output_set {
+    Function function;
+};
+
+// function( T* buffer, size_t count ) fills up to count elements and returns
+// how many. less than count (0) only at the end
+template<class Function>
+inline input_set<Function>
+input( Function function ) {
+    return { function };
+}
+
+// function( const T* buffer, size_t count ) gets every computed chunk
+template<class Function>
+inline output_set<Function>
+output( Function function ) {
+    return { function };
+}
+
+// the end of the stream ends the input, a read error (badbit) throws
+// std::ios_base::failure
+inline auto
+from_istream( std::istream& in ) {
+    return input( [&in]( auto* buffer, const size_t count ) {
+        const size_t ELEMENT = sizeof( *buffer );
+        in.read( (char*)buffer, count * ELEMENT );
+        if ( in.bad() ) {
+            throw std::ios_base::failure( "vecex::stream::from_istream" );
+        }
+        return (size_t)in.gcount() / ELEMENT;
+    } );
+}
+
+// throws std::ios_base::failure if the stream fails to write
+inline auto
+to_ostream( std::ostream& out ) {
+    return output( [&out]( const auto* buffer, const size_t count ) {
+        out.write( (const char*)buffer, count * sizeof( *buffer ) );
+        if ( !out ) {
+            throw std::ios_base::failure( "vecex::stream::to_ostream" );
+        }
+    } );
+}
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+// read() returns less than asked for pipes and sockets, the driver asks
+// again until the chunk is full or read() returns 0. interrupted calls are
+// repeated, other errors throw std::system_error
+inline auto
+from_fd( const int fd ) {
+    return input( [fd]( auto* buffer, const size_t count ) {
+        for ( ;; ) {
+            const ssize_t bytes
+                    = ::read( fd, buffer, count * sizeof( *buffer ) );
+            if ( bytes >= 0 ) {
+                return (size_t)bytes / sizeof( *buffer );
+            }
+            if ( errno != EINTR ) {
+                throw std::system_error(
+                        errno, std::generic_category(), "read" );
+            }
+        }
+    } );
+}
+
+inline auto
+to_fd( const int fd ) {
+    return output( [fd]( const auto* buffer, const size_t count ) {
+        const char* data = (const char*)buffer;
+        size_t      left = count * sizeof( *buffer );
+        while ( left > 0 ) {
+            const ssize_t bytes = ::write( fd, data, left );
+            if ( bytes < 0 && errno == EINTR ) {
+                continue;
+            }
+            if ( bytes <= 0 ) {
+                throw std::system_error( bytes < 0 ? errno : EIO,
+                                         std::generic_category(),
+                                         "write" );
+            }
+            data += bytes;
+            left -= bytes;
+        }
+    } );
+}
+#endif
+
+}    // namespace stream
+
+namespace internal {
+namespace stream {
+
+template<class Set>
+struct is_input : std::false_type {};
+template<class Function>
+struct is_input<vecex::stream::input_set<Function>> : std::true_type {};
+
+template<class Set>
+struct is_output : std::false_type {};
+template<class Function>
+struct is_output<vecex::stream::output_set<Function>> : std::true_type {};
+
+// fills the buffer of an input, other data sets are always full
+template<class CalcType, class Set>
+inline size_t
+fill( Set& set, CalcType* buffer, const size_t chunk ) {
+    if constexpr ( is_input<Set>::value ) {
+        size_t filled = 0;
+        while ( filled < chunk ) {
+            const size_t count
+                    = set.function( buffer + filled, chunk - filled );
+            if ( count == 0 ) {
+                break;
+            }
+            filled += count;
+        }
+        return filled;
+    } else {
+        return chunk;
+    }
+}
+
+template<class CalcType, class Set>
+inline void
+drain( Set& set, const CalcType* buffer, const size_t count ) {
+    if constexpr ( is_output<Set>::value ) {
+        if ( count > 0 ) {
+            set.function( buffer, count );
+        }
+    }
+}
+
+// the buffers of every data set for one chunk
+template<class CalcType, size_t size>
+struct Chunk {
+    std::array<vecex::vector<CalcType>, size> buffers;
+    std::array<CalcType*, size>               data_sets;
+    size_t                                    count = 0;
+
+    explicit Chunk( const size_t elements ) {
+        for ( size_t i = 0; i < size; i++ ) {
+            this->buffers[i].resize( elements );
+            this->data_sets[i] = this->buffers[i].data();
+        }
+    }
+
+    template<class Sets, size_t... I>
+    void
+    fill( Sets& sets, const size_t chunk, std::index_sequence<I...> ) {
+        this->count = chunk;
+        ( ( this->count = std::min(
+                    this->count,
+                    stream::fill( std::get<I>( sets ),
+                                  this->data_sets[I],
+                                  chunk ) ) ),
+          ... );
+    }
+
+    template<class Sets, size_t... I>
+    void
+    drain( Sets& sets, std::index_sequence<I...> ) const {
+        ( stream::drain(
+                  std::get<I>( sets ), this->data_sets[I], this->count ),
+          ... );
+    }
+};
+
+}    // namespace stream
+}    // namespace internal
+
+template<class CalcType,
+         class... Sets,
+         class Function,
+         class Policy = policy<>>
+size_t
+compute_stream( std::tuple<Sets...> sets,
+                Function            func,
+                const size_t        chunk_elements
+                = stream::default_chunk_bytes / sizeof( CalcType ),
+                Policy = {} ) {
+    static_assert( ( ( internal::stream::is_input<Sets>::value
+                       || internal::stream::is_output<Sets>::value )
+                     && ... ),
+                   "every data set has to be a stream input or output" );
+    static_assert( ( internal::stream::is_input<Sets>::value || ... ),
+                   "compute_stream needs an input, it ends with the first" );
+
+    typedef internal::stream::Chunk<CalcType, sizeof...( Sets )> Chunk;
+    const auto   INDICES = std::index_sequence_for<Sets...> {};
+    const size_t ALIGN = simd_alignment / sizeof( CalcType );
+    const size_t CHUNK = ( chunk_elements + ALIGN - 1 ) / ALIGN * ALIGN;
+
+    std::array<Chunk, 2> chunks { Chunk( CHUNK ), Chunk( CHUNK ) };
+    chunks[0].fill( sets, CHUNK, INDICES );
+
+    auto&  pool = internal::parallel::Pool::instance();
+    size_t total = 0;
+    size_t current = 0;
+    for ( ; chunks[current].count > 0; current = 1 - current ) {
+        Chunk& work = chunks[current];
+        Chunk& io = chunks[1 - current];
+
+        // io still holds the last computed chunk. write it out and refill
+        // it, unless the current chunk already reached the end
+        auto io_task = [&]() {
+            io.drain( sets, INDICES );
+            io.count = 0;
+            if ( work.count == CHUNK ) {
+                io.fill( sets, CHUNK, INDICES );
+            }
+        };
+        auto task = [&]( const size_t index ) {
+            if ( index == 0 ) {
+                internal::compute::run_range<Policy>(
+                        work.data_sets, 0, work.count, work.count, func );
+            } else {
+                io_task();
+            }
+        };
+        if ( pool.max_tasks() > 1 ) {
+            pool.run( 2, task );
+        } else {
+            io_task();
+            task( 0 );
+        }
+        total += work.count;
+    }
+    chunks[1 - current].drain( sets, INDICES );
+    return total;
+}
+
+#ifdef VECEX_NAMESPACE
+}
+#endif
+
+}    // namespace vecex